@@ -0,0 +1,605 @@
+// headless benchmarks, prints one json object per line:
+//   {"name": ..., "iters": ..., "ns_per_op": ..., "allocs_per_op": ..., "p50_ns": ..., "p99_ns": ..., "max_ns": ...}
+// usage: kingdom_bench [--filter <substring>] [--iters <n>] [--threads <n>] [--budget <stat>=<max>]...
+//   --threads is how many threads run jobs, all cores by default
+//   --budget fails the run (exit 2) when a frame/ case averages more than <max> of
+//   a Screen::Stats field per frame, e.g. --budget draw_calls=2000
+// run it from build/ like the game so assets resolve
+
+#include "base.hpp"
+#include "building.hpp"
+#include "building_type.hpp"
+#include "person.hpp"
+#include "rng.hpp"
+#include "scene_gen.hpp"
+#include "world.hpp"
+#include "jobs.hpp"
+#include "input_queue.hpp"
+#include "protocol.hpp"
+#include "save.hpp"
+#include "base_store.hpp"
+#include "autosave.hpp"
+#include "particles.hpp"
+#include "render_snapshot.hpp"
+#include "renderer.hpp"
+#include "screen.hpp"
+#include "tile.hpp"
+#include "alloc_tracker.hpp"
+#include "frame_arena.hpp"
+#include "sdl2.hpp"
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::string filter;
+int iters = 1000;
+
+struct Budget
+{
+	int field;
+	double max;
+};
+std::vector<Budget> budgets;
+bool over_budget = false;
+
+// times every op on its own so percentiles show frame spikes, not just the mean
+void run(std::string const& name, std::function<void()> const& op, int n = iters)
+{
+	if (!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+
+	// warm up caches and lazily loaded textures
+	for (int i = 0; i < std::max(1, n / 10); ++i)
+	{
+		op();
+		FrameArena::get().reset();
+	}
+
+	std::vector<long long> times(n);
+	auto const allocs = alloc::count();
+	auto const bytes = alloc::bytes();
+
+	for (int i = 0; i < n; ++i)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		op();
+		auto const end = std::chrono::steady_clock::now();
+
+		// every op stands in for a frame
+		FrameArena::get().reset();
+
+		times[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	}
+
+	double const allocs_per_op = (double)(alloc::count() - allocs) / n;
+	double const bytes_per_op = (double)(alloc::bytes() - bytes) / n;
+
+	long long total = 0;
+	for (auto t : times)
+		total += t;
+
+	std::sort(times.begin(), times.end());
+	auto pct = [&](double p) { return times[std::min(n - 1, (int)(p * n))]; };
+
+	std::printf("{\"name\": \"%s\", \"iters\": %d, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, "
+		"\"bytes_per_op\": %.1f, \"p50_ns\": %lld, \"p90_ns\": %lld, \"p99_ns\": %lld, \"max_ns\": %lld}\n",
+		name.c_str(), n, (double)total / n, allocs_per_op, bytes_per_op,
+		pct(0.5), pct(0.9), pct(0.99), times.back());
+	std::fflush(stdout);
+}
+
+// random obstacles, pathing needs the same size as the base
+std::vector<std::vector<Tile>> generate_map(int w, int h, double occupied, unsigned seed)
+{
+	std::mt19937 eng(seed);
+	std::bernoulli_distribution occ(occupied), road(0.1);
+
+	std::vector<std::vector<Tile>> tiles(h, std::vector<Tile>(w, Tile{ TileState::GRASS }));
+	for (auto& row : tiles)
+	{
+		for (auto& tile : row)
+			tile.state = occ(eng) ? TileState::OCCUPIED : road(eng) ? TileState::PATH : TileState::GRASS;
+	}
+
+	return tiles;
+}
+
+void bench_pathing()
+{
+	int const w = Base::get().TILES_X, h = Base::get().TILES_Y;
+
+	for (double occupied : { 0.0, 0.2, 0.4 })
+	{
+		auto tiles = generate_map(w, h, occupied, 1);
+		tiles[h / 2][w / 2].state = TileState::GRASS;
+
+		Person person{ { w / 2, h / 2 }, { 0, 0 } };
+		Rng rng(1);
+		run("path/generate_path/occupied=" + std::to_string((int)(occupied * 100)) + "%", [&] {
+			person.path.clear();
+			person.generate_path(tiles, rng);
+		}, iters / 10);
+	}
+}
+
+void bench_placement()
+{
+	for (int type = 0; type < BuildingCatalog::get().size(); ++type)
+	{
+		auto building = Building::create(type, 0, 0);
+
+		run("placement/can_place_building_sweep/" + building->get_type().name, [&] {
+			int placeable = 0;
+			for (int y = 60; y < Screen::get().SCREEN_HEIGHT; y += 20)
+			{
+				for (int x = 5; x < Screen::get().SCREEN_WIDTH; x += 20)
+				{
+					building->snap_to(x, y);
+					placeable += Base::get().can_place_building(*building) == 0;
+				}
+			}
+
+			// keep the sweep from being optimized out
+			static volatile int sink;
+			sink = placeable;
+		}, iters / 10);
+	}
+}
+
+void bench_production()
+{
+	int prod_type = 0;
+	while (prod_type < BuildingCatalog::get().size() && !BuildingCatalog::get()[prod_type].prod)
+		prod_type++;
+
+	if (prod_type == BuildingCatalog::get().size())
+		return;
+
+	for (int n : { 100, 1000, 10000 })
+	{
+		std::vector<std::shared_ptr<Building>> buildings;
+		for (int i = 0; i < n; ++i)
+			buildings.push_back(Building::create(prod_type, 0, 0));
+
+		run("production/add_resources/buildings=" + std::to_string(n), [&] {
+			for (auto& building : buildings)
+				building->add_resources();
+		});
+	}
+}
+
+// one game frame as the sim and render threads split it, run back to back
+RenderSnapshot frame_snapshot;
+
+void sim_and_draw(bool second)
+{
+	Base::get().tick(second);
+	Base::get().update_ui();
+	Base::get().capture(frame_snapshot);
+
+	Renderer::get().draw(frame_snapshot);
+}
+
+void bench_particles()
+{
+	ProdType const sprite = ProdType::WHEAT;
+	Rng rng(1);
+
+	run("particles/update/full_pool", [&] {
+		if (Particles::get().size() < Particles::CAPACITY / 2)
+			Particles::get().spawn(rng, sprite, 500, 300, Particles::CAPACITY);
+		Particles::get().update();
+	});
+
+	run("particles/spawn_50_buildings", [&] {
+		for (int i = 0; i < 50; ++i)
+			Particles::get().spawn(rng, sprite, 100 + i * 20, 300, 10);
+		while (Particles::get().size() > 0)
+			Particles::get().update();
+	}, iters / 10);
+
+	run("particles/capture/full_pool", [&] {
+		if (Particles::get().size() < Particles::CAPACITY / 2)
+			Particles::get().spawn(rng, sprite, 500, 300, Particles::CAPACITY);
+		Particles::get().capture(frame_snapshot.particles);
+	});
+
+	run("particles/display/full_pool", [&] {
+		if (Particles::get().size() < Particles::CAPACITY / 2)
+			Particles::get().spawn(rng, sprite, 500, 300, Particles::CAPACITY);
+		Base::get().capture(frame_snapshot);
+		Renderer::get().draw_scene(frame_snapshot);
+	}, iters / 10);
+}
+
+// renders whole frames and reports the per frame render stats next to the timings
+void bench_frame()
+{
+	std::string const name = "frame/home_base";
+	if (!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+
+	auto& screen = Screen::get();
+	int const n = iters / 10;
+
+	Screen::Stats total{};
+	run(name, [&] {
+		sim_and_draw(false);
+		screen.update();
+		total += screen.last_frame_stats();
+	}, n);
+
+	// the warm up frames in run() are counted too
+	int const frames = n + std::max(1, n / 10);
+
+	std::printf("{\"name\": \"%s/stats\", \"frames\": %d", name.c_str(), frames);
+	for (std::size_t i = 0; i < std::size(Screen::Stats::FIELDS); ++i)
+		std::printf(", \"%s\": %.1f", Screen::Stats::FIELD_NAMES[i], (double)(total.*Screen::Stats::FIELDS[i]) / frames);
+	std::printf("}\n");
+
+	for (auto const& budget : budgets)
+	{
+		double const avg = (double)(total.*Screen::Stats::FIELDS[budget.field]) / frames;
+		if (avg > budget.max)
+		{
+			std::cout << "[error] - " << name << " " << Screen::Stats::FIELD_NAMES[budget.field]
+				<< " " << avg << " per frame is over the budget of " << budget.max << '\n';
+			over_budget = true;
+		}
+	}
+
+	std::fflush(stdout);
+}
+
+// frame time against scene size, for scaling curves
+void bench_scaling()
+{
+	auto frame = [](StressScene& scene) {
+		scene.update();
+		sim_and_draw(false);
+		Screen::get().update();
+	};
+
+	for (int n : { 0, 100, 500, 2000 })
+	{
+		SceneConfig config;
+		config.tiles_x = 200;
+		config.tiles_y = 100;
+		config.buildings = n;
+
+		StressScene scene(config);
+		scene.generate();
+		run("scale/buildings=" + std::to_string(n), [&] { frame(scene); }, iters / 10);
+	}
+
+	for (int n : { 10, 100, 1000 })
+	{
+		SceneConfig config;
+		config.tiles_x = 200;
+		config.tiles_y = 100;
+		config.villagers = n;
+
+		StressScene scene(config);
+		scene.generate();
+		run("scale/villagers=" + std::to_string(n), [&] { frame(scene); }, iters / 10);
+	}
+
+	for (int n : { 100, 1000, Particles::CAPACITY })
+	{
+		SceneConfig config;
+		config.particles = n;
+
+		StressScene scene(config);
+		scene.generate();
+		run("scale/particles=" + std::to_string(n), [&] { frame(scene); }, iters / 10);
+	}
+}
+
+void bench_save()
+{
+	SceneConfig config;
+	config.tiles_x = 200;
+	config.tiles_y = 100;
+	config.buildings = 2000;
+
+	StressScene scene(config);
+	scene.generate();
+
+	std::string const path = "bench.sav";
+
+	run("save/snapshot/buildings=2000", [&] { Base::get().snapshot(); }, iters / 10);
+
+	auto const snap = Base::get().snapshot();
+	run("save/encode/buildings=2000", [&] { save::encode(snap); }, iters / 10);
+	run("save/compress/buildings=2000", [&] { save::compress(save::encode(snap)); }, iters / 10);
+	run("save/write/buildings=2000", [&] { save::save(Base::get(), path); }, iters / 100 + 1);
+	run("save/load/buildings=2000", [&] { save::load(Base::get(), path); }, iters / 10);
+
+	// production ticks every 10th frame so saves in flight force layer copies
+	int frame = 0;
+	auto tick = [&](Autosave* autosave) {
+		sim_and_draw(++frame % 10 == 0);
+		if (autosave)
+			autosave->update(Base::get());
+		Screen::get().update();
+	};
+
+	run("save/frame/autosave=off", [&] { tick(nullptr); }, iters / 10);
+	{
+		Autosave autosave(path, 0);
+		run("save/frame/autosave=on", [&] { tick(&autosave); }, iters / 10);
+		std::printf("{\"name\": \"save/frame/autosave=on/saves\", \"saves\": %d}\n", autosave.get_saves());
+	}
+
+	std::remove(path.c_str());
+	std::remove((path + ".tmp").c_str());
+}
+
+bool parse_budget(std::string const& arg)
+{
+	auto const eq = arg.find('=');
+	if (eq == std::string::npos)
+		return false;
+
+	for (std::size_t i = 0; i < std::size(Screen::Stats::FIELD_NAMES); ++i)
+	{
+		if (arg.compare(0, eq, Screen::Stats::FIELD_NAMES[i]) == 0)
+		{
+			budgets.push_back(Budget{ (int)i, std::atof(arg.c_str() + eq + 1) });
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// what a fork and join costs, below this work isn't worth a job
+void bench_jobs()
+{
+	std::vector<float> data(1 << 16, 1.f);
+	auto scale = [&](int begin, int end) {
+		for (int i = begin; i < end; ++i)
+			data[i] *= 1.0001f;
+	};
+
+	run("jobs/spawn_wait", [&] {
+		Jobs::Group group;
+		Jobs::get().spawn(group, [] {});
+		Jobs::get().wait(group);
+	});
+	run("jobs/parallel_for/n=65536/serial", [&] { scale(0, data.size()); });
+	run("jobs/parallel_for/n=65536/grain=4096", [&] { Jobs::get().parallel_for(data.size(), 4096, scale); });
+}
+
+// a STATE for a 20 building base after a production tick, and after a
+//   tick where nothing happened
+void bench_net()
+{
+	std::string const name = "net/state";
+	if (!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+
+	World world;
+	SceneConfig config;
+	config.buildings = 20;
+
+	Base& base = world.add(1);
+	StressScene scene(config, base);
+	scene.generate();
+
+	std::vector<char> out;
+	auto acked = base.snapshot();
+	base.tick(true);
+	auto cur = base.snapshot();
+
+	run(name + "/produce/buildings=20", [&] {
+		out.clear();
+		net::write_state(out, 2, 1, acked, cur);
+	});
+
+	// once every building is full a production tick changes nothing, and
+	//   farmers walking isn't state, so an idle base sends nothing
+	for (int i = 0; i < 10000; ++i)
+	{
+		auto const prev = base.snapshot();
+		base.tick(true);
+		cur = base.snapshot();
+		if (!net::state_changed(prev, cur))
+			break;
+	}
+
+	base.tick(true);
+	auto const next = base.snapshot();
+	std::size_t idle = 0;
+	if (net::state_changed(cur, next))
+	{
+		std::vector<char> idle_out;
+		net::write_state(idle_out, 3, 2, cur, next);
+		idle = idle_out.size();
+	}
+
+	std::printf("{\"name\": \"%s/bytes\", \"produce_tick\": %zu, \"idle_tick\": %zu}\n", name.c_str(), out.size(), idle);
+	std::fflush(stdout);
+}
+
+// matching an attack against stored bases, with a quarter of them fitting
+//   in the mapped cache so most picks map a save
+void bench_store()
+{
+	std::string const name = "store/find";
+	if (!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+
+	int const bases = 5000;
+
+	World world;
+	SceneConfig config;
+	config.buildings = 20;
+
+	Base& base = world.add(1);
+	StressScene scene(config, base);
+	scene.generate();
+
+	auto snap = base.snapshot();
+	std::size_t const save_bytes = save::encode(snap).size();
+
+	std::string const dir = "bench_store";
+	{
+		BaseStore store(save_bytes * bases / 4);
+		if (!store.open(dir))
+			return;
+
+		Rng rng(1);
+		for (int i = 0; i < bases; ++i)
+		{
+			snap.header.troph = rng.range(0, 5000);
+			store.put(i + 1, snap);
+		}
+
+		BaseStore::Rival rival;
+		run(name + "/bases=5000", [&] { store.find_opponent(rng.range(0, 5000), 0, rng, rival); });
+
+		std::printf("{\"name\": \"%s/bases=5000/cache\", \"mapped_kb\": %.1f}\n", name.c_str(), store.mapped_bytes() / 1024.0);
+		std::fflush(stdout);
+	}
+
+	std::error_code ec;
+	std::filesystem::remove_all(dir, ec);
+}
+
+// one tick's worth of mouse input through the ring, as the sim drains it
+void bench_input()
+{
+	InputQueue queue;
+	std::vector<InputEvent> events;
+	events.reserve(InputQueue::CAPACITY);
+
+	run("input/queue/drags=64", [&] {
+		for (int i = 0; i < 64; ++i)
+			queue.push(InputEvent{ 0, (uint32_t)i, InputType::DRAG, (int16_t)i, (int16_t)i });
+
+		events.clear();
+		InputEvent e;
+		while (queue.pop(e))
+			events.push_back(e);
+		coalesce_drags(events);
+	});
+}
+
+// ticks per second a server can afford is what bases per core comes from,
+//   run with --threads 1, 2, 4... to see it scale
+void bench_world()
+{
+	int const bases = 1000;
+
+	World world;
+	for (int i = 0; i < bases; ++i)
+	{
+		SceneConfig config;
+		config.buildings = 20;
+		config.seed = i + 1;
+
+		StressScene scene(config, world.add(i + 1));
+		scene.generate();
+	}
+
+	int tick = 0;
+	run("world/bases=" + std::to_string(bases) + "/threads=" + std::to_string(Jobs::get().size()),
+		[&] { world.tick(++tick % 10 == 0); }, iters / 10);
+}
+
+void bench_screen()
+{
+	auto& screen = Screen::get();
+	screen.fill(sdl2::clr_white);
+	screen.stroke(sdl2::clr_black);
+
+	screen.line_mode(sdl2::LineMode::ALIASING);
+	run("screen/line/aliased", [&] { screen.line(10, 10, 500, 300); });
+
+	screen.line_mode(sdl2::LineMode::ANTIALIASING);
+	run("screen/line/antialiased", [&] { screen.line(10, 10, 500, 300); });
+
+	run("screen/trig", [&] { screen.trig(200, 200, 250, 150, 250, 250); });
+	run("screen/rhom", [&] { screen.rhom(400, 300, 100, 50); });
+
+	screen.rect_align(sdl2::RectAlign::CORNERS);
+	run("screen/rect", [&] { screen.rect(100, 100, 200, 100); });
+
+	screen.rect_align(sdl2::RectAlign::CENTER);
+	run("screen/rect/rounded", [&] { screen.rect(300, 300, 70, 70, 15); });
+
+	run("screen/circle", [&] { screen.circle(300, 300, 20); });
+
+	screen.text_font(sdl2::str_brygada);
+	screen.text_size(24);
+	screen.text_align(sdl2::TextAlign::CENTER_LEFT);
+	run("screen/text", [&] { screen.text("Gold: 250", 100, 100); }, iters / 10);
+
+	screen.image_align(sdl2::ImageAlign::CENTER);
+	run("screen/image", [&] { screen.image("farmhouse.png", 500, 300, 310, 198); });
+	run("screen/clear", [&] { screen.clear(); }, iters / 10);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			filter = argv[++i];
+		else if (std::strcmp(argv[i], "--iters") == 0 && i + 1 < argc)
+			iters = std::max(10, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			Jobs::get().start(std::max(1, std::atoi(argv[++i])) - 1);
+		else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc && parse_budget(argv[i + 1]))
+			i++;
+		else
+		{
+			std::cout << "usage: kingdom_bench [--filter <substring>] [--iters <n>] [--threads <n>] [--budget <stat>=<max>]...\n";
+			return 1;
+		}
+	}
+
+	if (TTF_Init() == -1)
+	{
+		std::cout << "error - failed to initialize TTF\n    " << TTF_GetError();
+		return 1;
+	}
+
+	Screen::get().set_headless();
+
+	bench_pathing();
+	bench_placement();
+	bench_production();
+	bench_particles();
+	bench_screen();
+	bench_frame();
+	bench_scaling();
+	bench_save();
+	bench_jobs();
+	bench_input();
+	bench_net();
+	bench_store();
+	bench_world();
+
+	return over_budget ? 2 : 0;
+}
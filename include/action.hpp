@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+enum class ActionType : uint16_t
+{
+	PLACE,		// a = building type, b = x, c = y snapped to the grid, pays the building's cost
+	COLLECT,	// a = index into the base's buildings
+	PRODUCE,	// the once a second production tick
+	MOVE		// a = index into the base's buildings, b = x, c = y snapped to the grid
+};
+
+// a change to the saved state of a Base, small enough to journal every one
+struct Action
+{
+	ActionType type;
+	int32_t a, b, c;
+};
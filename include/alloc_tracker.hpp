@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// counts heap allocations made through global operator new
+// only hooked when built with KINGDOM_TRACK_ALLOCS, otherwise always 0
+// allocations are attributed to the innermost PROFILE_SCOPE open on the
+//   allocating thread, so KINGDOM_PROFILE is needed for a per zone breakdown
+namespace alloc
+{
+
+std::size_t count();
+// made by the calling thread, for checking code that shares the process
+//   with the sim, the job workers and the save threads
+std::size_t thread_count();
+std::size_t bytes();
+std::size_t frees();
+
+struct ZoneAllocs
+{
+	char const* name;
+	std::size_t count;
+	std::size_t bytes;
+};
+
+// totals since startup, most allocations first
+std::vector<ZoneAllocs> zones();
+
+enum class BudgetAction
+{
+	LOG,
+	ASSERT
+};
+
+std::size_t const NO_BUDGET = (std::size_t)-1;
+
+// the first warmup_frames frames load textures and fonts and are not checked
+void set_frame_budget(std::size_t max_allocs, BudgetAction const action, int warmup_frames = 60);
+
+// call once at the end of every frame, returns the allocations made since the
+//   previous call and logs the worst zones (or aborts) when over the budget
+// the count is process wide, so whatever the sim, job and save threads
+//   allocated meanwhile is charged to the frame too
+std::size_t end_frame();
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "save.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Base;
+
+// saves the base every so often without the frame waiting on it
+// update() only shares the base's save layers at the frame boundary, the
+//   encoding, compression and write happen on the autosave thread
+class Autosave
+{
+public:
+	Autosave(std::string const& _path, int const _interval_ms);
+	~Autosave();
+
+	Autosave(Autosave const&) = delete;
+	void operator=(Autosave const&) = delete;
+
+public:
+	// once a frame, skipped while the previous save is still being written
+	void update(Base const& base);
+
+	bool is_busy() const;
+	int get_saves() const;
+
+private:
+	void worker_loop();
+
+private:
+	std::string path;
+	int interval_ms;
+	uint64_t last_ms;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::unique_ptr<save::Snapshot> job;
+	bool stopping;
+
+	std::atomic<bool> busy;
+	std::atomic<int> saves;
+
+	std::thread worker;
+};
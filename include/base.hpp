@@ -4,53 +4,103 @@
 #include "tile.hpp"
 #include "sdl2.hpp"
 #include "building.hpp"
+#include "depth_sort.hpp"
+#include "rng.hpp"
+#include "action.hpp"
+#include "save.hpp"
+#include "render_snapshot.hpp"
 
 #include <SDL.h>
 
 #include <functional>
 #include <random>
 #include <string>
+#include <utility>
 #include <vector>
-#include <set>
 
 class Base
 {
 public:
+    // the game's base, the server makes one per player instead
     static Base& get();
 
+    Base();
+
 public:
     Base(Base const&) = delete;
     void operator=(Base const&) = delete;
 
-    void set_building_dim();
-
 public:
-    void display_resources();
-	void display_scene(bool second);
-    void display_shop();
+    // farmers walk and every second buildings produce
+    void tick(bool second);
+    // the shop slides and messages fade, once a tick for the base on screen
+    void update_ui();
+    // copies what the renderer draws into s, after the tick
+    void capture(RenderSnapshot& s);
 
     void handle_mouse_pressed(int x, int y);
     void handle_mouse_dragged(int x, int y);
 	void handle_mouse_released(int x, int y); // dragged then released
 	
-private:
-    Base();
-
     // 0 - yes, 1 - occupied, 2 - out of bounds
     int can_place_building(Building const& b) const;
-    void update_base_buildings(Building* building, bool shrink = false, int x = -1, int y = -1);
-    void display_farmers();
-    void display_base_buildings();
-    void manage_resources(bool second);
-    void not_enough_resources();
-    void display_grid();
+
+    // restarts every random stream, for replays
+    void seed(uint64_t const seed);
+
+    // empties the base and resizes it, for generated scenes
+    void reset(int const tiles_x, int const tiles_y);
+    // free of charge, false if the spot isn't legal
+    bool add_building(int const type, int x, int y);
+    bool add_farmer(int const tile_x, int const tile_y);
+
+    int building_count() const;
+    int farmer_count() const;
+
+    // every change to the saved state goes through perform(), which applies
+    //   it and then hands it to on_action so it can be journaled
+    bool perform(Action const& action);
+    // false if the action doesn't fit this base, e.g. a replayed placement
+    //   onto an occupied spot
+    bool apply(Action const& action);
+
+    // everything a save needs, copied out so it can be encoded off thread
+    save::Snapshot snapshot() const;
+    // replaces the base with a loaded one, farmers and the preview are reset
+    void restore(save::View const& v);
+
+    // where the shop shows a building type
+    static sdl2::Dimension shop_dim(int type);
+
+private:
+    void commit_place();
+    void occupy(Building const& b);
+    void vacate(Building const& b);
+    // the tiles b stands on, inclusive
+    void footprint(Building const& b, int& x1, int& y1, int& x2, int& y2) const;
+    // sets the tiles b stands on inside the clip to its state where that's
+    //   higher, occupied over path over grass
+    void raise_tiles(Building const& b, int cx1, int cy1, int cx2, int cy2);
+    bool insert_building(std::shared_ptr<Building> building);
+
+    std::vector<uint8_t>& writable_tile_layer();
+    std::vector<save::BuildingRecord>& writable_building_layer();
+    save::BuildingRecord record_of(Building const& b) const;
+    void update_farmers();
 
 public:
 	int gold, wheat, wood, stone, iron, gems;
 	int level, exp, troph;
 	bool edit_mode;
 
-    int const TILES_X, TILES_Y;
+	RngStreams rng;
+
+	// no particles or sprite lookups, for bases nobody is looking at
+	bool headless;
+
+	std::function<void(Action const&)> on_action;
+
+    int TILES_X, TILES_Y;
 
     enum class ShopState
     {
@@ -59,6 +109,7 @@ public:
         APPEARING,
         DISAPPEARING
     } shop_state;
+    int shop_y;
 
     enum class PlaceState
     {
@@ -66,23 +117,29 @@ public:
         FOLLOW_MOUSE
     };
 
-private:
-    struct shared_ptr_comp
-    {
-        bool operator() (std::shared_ptr<Building> const& a,
-                         std::shared_ptr<Building> const& b) const;
-    };
-
 private:
     std::vector<std::vector<Tile>> tiles;
     std::vector<Person> farmers;
-    std::vector<std::unique_ptr<Building>> shop_buildings;
+    std::vector<std::pair<int, uint64_t>> path_requests; // farmer, path seed
 
-	std::set<std::shared_ptr<Building>, shared_ptr_comp> base_buildings;
-    std::shared_ptr<Building> place;
+	std::vector<std::shared_ptr<Building>> base_buildings;
+
+    // tiles and base_buildings in save layout, kept in step with them so a
+    //   snapshot only has to share these
+    std::shared_ptr<std::vector<uint8_t>> tile_layer;
+    std::shared_ptr<std::vector<save::BuildingRecord>> building_layer;
+    std::shared_ptr<Building> place; // preview, only added to base_buildings once confirmed
     PlaceState place_state;
     SDL_Point place_offset; // so when mouse dragged it doesn't teleport to mouse
 
+    DepthSort depth_sort;
+
+    // below these a loop isn't worth splitting into jobs, and a normal
+    //   sized base never is
+    static int const PATH_GRAIN = 2;
+    static int const STEER_GRAIN = 256;
+    static int const PRODUCE_GRAIN = 256;
+
     sdl2::Text text_build;
     std::vector<std::pair<int, sdl2::Text>> resources_msg;
 };
\ No newline at end of file
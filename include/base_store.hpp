@@ -0,0 +1,87 @@
+#pragma once
+
+#include "save.hpp"
+#include "mapped_file.hpp"
+#include "rng.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// rival bases for attacks, one uncompressed save per player in a directory
+//   so a base can be read straight out of its mapping
+// players are indexed by trophies in memory, the index is appended to a
+//   file next to the saves so opening the store doesn't read every save
+// a save is mapped and validated the first time it's picked, at most
+//   max_bytes of them stay mapped and the least recently picked go first
+class BaseStore
+{
+public:
+	explicit BaseStore(std::size_t const _max_bytes = 64 << 20);
+	~BaseStore();
+
+	BaseStore(BaseStore const&) = delete;
+	void operator=(BaseStore const&) = delete;
+
+public:
+	// a base picked as an opponent, holds its mapping open even if the
+	//   store drops it
+	struct Rival
+	{
+		uint64_t id;
+		save::View view;
+		std::shared_ptr<MappedFile const> file;
+	};
+
+	// creates dir if it isn't there and reads its index
+	bool open(std::string const& _dir);
+
+	// writes the save and indexes it under its trophies, replacing any
+	//   earlier one of the player's
+	bool put(uint64_t const id, save::Snapshot const& snap);
+
+	// a random base with trophies close to troph that isn't exclude, the
+	//   range widens until there's one, false if there's no one else
+	bool find_opponent(int const troph, uint64_t const exclude, Rng& rng, Rival& out);
+
+	int size() const;
+	std::size_t mapped_bytes() const;
+
+public:
+	// trophies either side of the player's the first search looks at
+	static int const MATCH_RANGE = 50;
+
+private:
+	struct Cached
+	{
+		std::shared_ptr<MappedFile const> file;
+		save::View view;
+		std::list<uint64_t>::iterator lru;
+	};
+
+	std::string path_of(uint64_t const id) const;
+	void index(uint64_t const id, int32_t const troph);
+	void unindex(uint64_t const id);
+	// maps and checks the save, nullptr if it's missing or bad
+	Cached const* load(uint64_t const id);
+	void evict(uint64_t const id);
+
+private:
+	std::string dir;
+	std::size_t max_bytes;
+	std::size_t bytes;
+	FILE* index_file;
+
+	// (trophies, id), sorted, a range of trophies is a range of the vector
+	std::vector<std::pair<int32_t, uint64_t>> by_troph;
+	std::unordered_map<uint64_t, int32_t> troph_of;
+
+	std::unordered_map<uint64_t, Cached> cache;
+	std::list<uint64_t> lru; // most recently picked first
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "tile.hpp"
+
+#include <string>
+#include <vector>
+
+enum class ProdType
+{
+	GOLD,
+	WHEAT,
+	WOOD,
+	STONE,
+	IRON
+};
+
+// the resource's icon in assets/
+char const* prod_img(ProdType const type);
+
+// stats shared by every building of a kind, buildings only store the index
+struct BuildingType
+{
+	std::string name;
+	std::string img;
+	int w, h;		   // size in the shop
+	double base_scale; // size on the base relative to the shop
+	int height_d;
+	int cost_gold, cost_wood, cost_stone, cost_iron;
+	TileState tile;
+
+	bool prod;
+	ProdType prod_type;
+	int rate;
+	int display_cap;
+	int storage_cap;
+};
+
+class BuildingCatalog
+{
+public:
+	static BuildingCatalog& get();
+
+public:
+	BuildingCatalog(BuildingCatalog const&) = delete;
+	void operator=(BuildingCatalog const&) = delete;
+
+public:
+	BuildingType const& operator[](int type) const;
+	int size() const;
+
+private:
+	// filled once from content::buildings, indices must match the generated table
+	BuildingCatalog();
+
+	// returns the index of the new type
+	int add(BuildingType const& type);
+
+private:
+	std::vector<BuildingType> types;
+};
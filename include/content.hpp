@@ -0,0 +1,45 @@
+#pragma once
+
+#include "tile.hpp"
+#include "building_type.hpp"
+
+// definitions generated from data/content.txt, see content_data.hpp
+
+namespace content
+{
+
+struct BuildingDef
+{
+	char const* name;
+	char const* img;
+	int w, h; // shop size
+	double base_scale;
+	int height_d;
+	int cost_gold, cost_wood, cost_stone, cost_iron;
+	TileState tile;
+
+	bool prod;
+	ProdType prod_type;
+	int rate, display_cap, storage_cap;
+};
+
+struct TroopDef
+{
+	char const* name;
+	char const* img;
+	int w, h;
+	int cost_gold, cost_wheat;
+	int hp, damage;
+	double speed;
+	int train_time;
+};
+
+struct UpgradeDef
+{
+	char const* building;
+	int level;
+	int cost_gold, cost_wood, cost_stone, cost_iron;
+	int rate, display_cap, storage_cap;
+};
+
+}
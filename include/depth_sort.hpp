@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+enum class DrawKind : uint8_t
+{
+	BUILDING,
+	PREVIEW,
+	FARMER
+};
+
+// something that is drawn in the isometric scene, (x,y) is the screen
+//   position of the sprite's base and is used as the sort key
+struct Drawable
+{
+	int x, y;
+	DrawKind kind;
+	int index;
+};
+
+// painter's order for the scene, rebuilt every frame
+// sorted by row then column using a two pass counting sort, so moving
+//   sprites cost the same as static ones
+class DepthSort
+{
+public:
+	DepthSort(int const _width, int const _height);
+
+public:
+	void clear();
+	void push(int x, int y, DrawKind const kind, int index);
+
+	// back to front, valid until the next clear()
+	std::vector<Drawable> const& sort();
+
+private:
+	void counting_sort(std::vector<Drawable> const& src, std::vector<Drawable>& dst, bool by_row);
+
+private:
+	int width, height;
+
+	std::vector<Drawable> drawables;
+	std::vector<Drawable> sorted;
+	std::vector<int> counts;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// bump allocator for data that only lives for one frame, one per thread
+// deallocate is a no-op and reset() rewinds everything at once, blocks are
+//   kept between frames so a steady frame never reaches malloc
+// the main thread's arena is reset by Screen::update()
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+	static FrameArena& get();
+
+	FrameArena(FrameArena const&) = delete;
+	void operator=(FrameArena const&) = delete;
+
+public:
+	struct Mark
+	{
+		std::size_t block;
+		std::size_t offset;
+	};
+
+	// frees everything allocated since the mark, for scratch space inside a frame
+	class Scope
+	{
+	public:
+		Scope()
+			: arena(FrameArena::get()), mark(arena.mark()) {}
+		~Scope() { arena.rewind(mark); }
+
+		Scope(Scope const&) = delete;
+		void operator=(Scope const&) = delete;
+
+	private:
+		FrameArena& arena;
+		Mark mark;
+	};
+
+	void reset();
+	Mark mark() const;
+	void rewind(Mark const& m);
+
+	std::size_t used() const;
+	std::size_t capacity() const;
+
+private:
+	FrameArena();
+
+	void* do_allocate(std::size_t bytes, std::size_t align) override;
+	void do_deallocate(void*, std::size_t, std::size_t) override {}
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+
+private:
+	static constexpr std::size_t BLOCK_SIZE = 256 * 1024;
+
+	std::vector<std::unique_ptr<std::byte[]>> blocks;
+	std::vector<std::size_t> block_sizes;
+
+	std::size_t block, offset;
+};
+
+template <typename T>
+using frame_vector = std::pmr::vector<T>;
+using frame_string = std::pmr::string;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// a session's input, as the calls main makes into Base, so replaying it
+//   doesn't depend on mouse timing or the drag threshold
+enum class InputType : uint8_t
+{
+	DOWN,      // left button went down, dismisses the tutorial
+	PRESS,
+	DRAG,
+	RELEASE,
+	SECOND,    // the once a second resource tick
+	FRAME      // end of a sim tick
+};
+
+struct InputEvent
+{
+	uint32_t frame;  // sim tick
+	uint32_t ms;     // since the start of the session
+	InputType type;
+	int16_t x, y;
+};
+
+// file layout, little endian:
+//   header  "NKIL", u32 version, u64 rng seed
+//   events  u32 frame, u32 ms, u8 type, i16 x, i16 y
+class InputRecorder
+{
+public:
+	bool open(std::string const& path, uint64_t const seed);
+	void write(InputEvent const& e);
+
+	bool is_open() const;
+
+private:
+	std::ofstream file;
+};
+
+class InputReplay
+{
+public:
+	bool open(std::string const& path);
+
+	// events of the next recorded frame, ending with its FRAME event,
+	//   false once the log runs out
+	bool next_frame(std::vector<InputEvent>& events);
+
+	uint64_t get_seed() const;
+
+private:
+	std::ifstream file;
+	uint64_t seed;
+};
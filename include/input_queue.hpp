@@ -0,0 +1,44 @@
+#pragma once
+
+#include "input_log.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// lock free ring from the event thread to the sim thread, one producer and
+//   one consumer
+// each side only writes its own index, and keeps a copy of the other's so
+//   it touches the shared cache line only when the copy says full or empty
+class InputQueue
+{
+public:
+	InputQueue();
+
+	InputQueue(InputQueue const&) = delete;
+	void operator=(InputQueue const&) = delete;
+
+public:
+	// event thread, false if the ring is full and e was dropped
+	bool push(InputEvent const& e);
+	// sim thread, false if there's nothing to pop
+	bool pop(InputEvent& e);
+
+public:
+	static uint32_t const CAPACITY = 1024; // a power of two
+
+private:
+	std::array<InputEvent, CAPACITY> events;
+
+	// free running, wrapped with & (CAPACITY - 1)
+	alignas(64) std::atomic<uint32_t> head; // next to pop
+	uint32_t cached_tail;                   // consumer's copy
+
+	alignas(64) std::atomic<uint32_t> tail; // next to push
+	uint32_t cached_head;                   // producer's copy
+};
+
+// a tick only needs where the mouse ended up, so each run of drags is cut
+//   down to its last one, presses and releases keep their order around them
+void coalesce_drags(std::vector<InputEvent>& events);
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work stealing job scheduler, one deque per worker
+// a worker runs its own newest job first and steals the oldest job of
+//   another when it runs out, waiting on a group runs other jobs instead of
+//   blocking, so jobs can fork and join more jobs
+// threads that aren't workers share one more deque, the main thread spawns
+//   there and only helps while it waits
+class Jobs
+{
+public:
+	static Jobs& get();
+
+	Jobs(Jobs const&) = delete;
+	void operator=(Jobs const&) = delete;
+
+public:
+	class Group;
+
+	struct Job
+	{
+		std::function<void()> fn;
+		Group* group;
+	};
+
+	// counts its jobs until they finish, wait() on it before it goes out of scope
+	class Group
+	{
+	public:
+		Group();
+
+		Group(Group const&) = delete;
+		void operator=(Group const&) = delete;
+
+		bool done() const;
+
+	private:
+		friend class Jobs;
+
+		std::atomic<int> pending;
+		std::mutex mutex;
+		std::vector<Job> after; // jobs waiting on this group
+	};
+
+public:
+	// worker threads besides the ones calling in, only before the first job,
+	//   by default every core but one
+	void start(int const workers);
+	// workers and the caller
+	int size();
+
+	void spawn(Group& group, std::function<void()> fn);
+	// fn is held back until after is done, group counts it from now
+	void spawn_after(Group& after, Group& group, std::function<void()> fn);
+	// runs jobs until every job in group is done
+	void wait(Group& group);
+
+	// fn(begin, end) over [0, count) in chunks of grain, the caller runs the
+	//   first one, anything under a grain doesn't touch the scheduler at all
+	// a grain under 1 is taken as 1
+	template <typename F>
+	void parallel_for(int const count, int grain, F const& fn)
+	{
+		grain = std::max(1, grain);
+
+		if (count <= grain || size() == 1)
+		{
+			if (count > 0)
+				fn(0, count);
+			return;
+		}
+
+		Group group;
+		for (int begin = grain; begin < count; begin += grain)
+		{
+			int const end = std::min(begin + grain, count);
+			spawn(group, [&fn, begin, end] { fn(begin, end); });
+		}
+
+		fn(0, grain);
+		wait(group);
+	}
+
+private:
+	Jobs();
+	~Jobs();
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void push(Job job);
+	bool pop(Job& job);
+	void run(Job& job);
+	void worker_loop(int const index);
+
+private:
+	std::once_flag started;
+
+	std::vector<std::unique_ptr<Queue>> queues; // 0 is for threads that aren't workers
+	std::vector<std::thread> threads;
+
+	std::atomic<int> queued;
+	std::atomic<int> sleeping;
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_cv;
+	std::atomic<bool> stopping;
+};
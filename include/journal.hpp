@@ -0,0 +1,79 @@
+#pragma once
+
+#include "action.hpp"
+#include "save.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Base;
+
+// append only log of every Action since the last save, so a crash loses at
+//   most one group commit worth of actions
+// appends only copy into a buffer, a writer thread writes and fsyncs them
+//   in groups, and compaction folds the log into the save on that thread too
+//
+//   file   "NKJL", u32 version, u32 seq of the save it follows, u32 0
+//   then   24 byte records, seq, type, args, checksum
+class Journal
+{
+public:
+	Journal();
+	~Journal();
+
+	Journal(Journal const&) = delete;
+	void operator=(Journal const&) = delete;
+
+public:
+	// loads the save, replays the journal over it and starts a fresh journal
+	// false without touching anything if the save is there but won't load
+	bool open(Base& base, std::string const& _save_path, std::string const& _journal_path);
+	// compacts and stops the writer
+	void close(Base const& base);
+
+	void append(Action const& action);
+
+	bool should_compact() const;
+	// takes the snapshot now, writing it happens on the writer thread
+	void compact(Base const& base);
+
+public:
+	static constexpr int GROUP_COMMIT_MS = 50;
+	static int const COMPACT_RECORDS = 4096;
+
+private:
+	struct Record
+	{
+		uint32_t seq;
+		uint16_t type;
+		uint16_t pad;
+		int32_t a, b, c;
+		uint32_t checksum;	// of the fields above, catches a torn last write
+	};
+	static_assert(sizeof(Record) == 24, "journal records must stay packed");
+
+	void writer_loop();
+	bool write_journal(uint32_t base_seq, std::vector<Record> const& records);
+	uint32_t replay(Base& base, uint32_t after_seq);
+
+private:
+	std::string save_path, journal_path;
+
+	FILE* file;
+	uint32_t seq;
+	int records_since_compact;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::vector<Record> pending;
+	std::unique_ptr<save::Snapshot> compact_snap;
+	bool stopping;
+
+	std::thread writer;
+};
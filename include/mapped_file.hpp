@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// a whole file mapped read only, the pages are only read in when touched
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile const&) = delete;
+	void operator=(MappedFile const&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+public:
+	bool open(std::string const& path);
+	void close();
+
+	char const* data() const;
+	std::size_t size() const;
+
+private:
+	char const* ptr;
+	std::size_t len;
+
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+};
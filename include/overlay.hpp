@@ -0,0 +1,51 @@
+#pragma once
+
+#include "screen.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// frame time graph and per frame counters, toggled with F3
+class Overlay
+{
+public:
+	static Overlay& get();
+
+public:
+	Overlay(Overlay const&) = delete;
+	void operator=(Overlay const&) = delete;
+
+	void toggle();
+
+	// called once the frame is presented, times are in nanoseconds
+	// frame_ns is the render thread's wall clock for the frame, what the
+	//   graph and percentiles show, sim_ns is the sim thread's latest tick,
+	//   which ran alongside it and is only shown next to it
+	void end_frame(uint64_t frame_ns, uint64_t sim_ns, uint64_t render_ns, uint64_t present_ns,
+		Screen::Stats const& stats, std::size_t allocs);
+	void display();
+
+public:
+	static constexpr int FRAMES = 240;
+
+private:
+	Overlay();
+
+	// milliseconds, p in [0, 1]
+	float percentile(float p);
+
+private:
+	bool visible;
+
+	std::array<float, FRAMES> frame_ms;
+	int frame_head;
+	int frame_count;
+
+	// latest frame
+	float sim_ms, render_ms, present_ms;
+	Screen::Stats stats;
+	std::size_t allocs;
+
+	std::array<float, FRAMES> sorted;
+};
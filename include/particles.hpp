@@ -0,0 +1,47 @@
+#pragma once
+
+#include "rng.hpp"
+#include "building_type.hpp"
+#include "render_snapshot.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// every collect-resource particle in the scene, stored as parallel arrays
+//   in a fixed pool so spawning and dying never allocates
+// simulated with the base, the renderer only sees them through a snapshot
+class Particles
+{
+public:
+	static Particles& get();
+
+public:
+	Particles(Particles const&) = delete;
+	void operator=(Particles const&) = delete;
+
+	// extra particles are dropped when the pool is full
+	void spawn(Rng& rng, ProdType const sprite, int x, int y, int n);
+	void update();
+	void capture(std::vector<RenderSnapshot::Particle>& out) const;
+
+	int size() const;
+
+public:
+	static int const CAPACITY = 2048;
+
+private:
+	Particles();
+
+	void remove(int i);
+
+private:
+	int count;
+
+	std::array<float, CAPACITY> x, y;
+	std::array<float, CAPACITY> vx, vy;
+	std::array<float, CAPACITY> ax, ay;
+	std::array<float, CAPACITY> jx, jy; // jerk!
+	std::array<float, CAPACITY> alpha;
+	std::array<ProdType, CAPACITY> sprite;
+};
@@ -1,21 +1,23 @@
 #pragma once
 
 #include "tile.hpp"
+#include "rng.hpp"
 
 #include <SDL.h>
 
-#include <random>
 #include <deque>
+#include <vector>
 
 struct Person
 {
-    void generate_path(std::vector<std::vector<Tile>> const& tiles);
+    // picks a random destination on the map and walks there
+    void generate_path(std::vector<std::vector<Tile>> const& tiles, Rng& rng);
+
+    // destinations tried before giving up for this step
+    static int const MAX_PATH_TRIES = 64;
 
     SDL_Point path_pos;
     SDL_FPoint actual_pos;
     std::deque<SDL_Point> path;
-
-    static std::random_device dev;
-    static std::mt19937 eng;
-    static std::uniform_int_distribution<std::mt19937::result_type> distrx, distry;
+    int steps_left = 0; // until actual_pos reaches path[0]
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// scope timers written to a per thread ring buffer and exported as a
+//   chrome trace (chrome://tracing or ui.perfetto.dev)
+// zones compile out unless built with KINGDOM_PROFILE, and cost a single
+//   flag check until prof::set_enabled(true)
+
+namespace prof
+{
+
+void set_enabled(bool const enabled);
+bool is_enabled();
+
+uint64_t now_ns();
+// name must outlive the profiler, use string literals
+void record(char const* name, uint64_t start_ns, uint64_t end_ns);
+
+// only the newest events of each thread are kept, older ones are overwritten
+// safe while other threads are still recording, events they overwrite
+//   during the export are left out
+bool write_chrome_trace(std::string const& path);
+
+// innermost zone open on this thread, nullptr outside of any zone
+// kept even while recording is disabled so allocations can be attributed
+char const* current_zone();
+char const* enter_zone(char const* name);
+void leave_zone(char const* parent);
+
+class Zone
+{
+public:
+	explicit Zone(char const* _name)
+		: name(_name), parent(enter_zone(_name)), start(is_enabled() ? now_ns() : 0) {}
+
+	~Zone()
+	{
+		if (start)
+			record(name, start, now_ns());
+		leave_zone(parent);
+	}
+
+	Zone(Zone const&) = delete;
+	void operator=(Zone const&) = delete;
+
+private:
+	char const* name;
+	char const* parent;
+	uint64_t start;
+};
+
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef KINGDOM_PROFILE
+#define PROFILE_SCOPE(name) prof::Zone PROFILE_CONCAT(prof_zone_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "save.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// messages between the server and its clients, little endian like saves
+//
+//   every message   u32 size of the whole message, u8 MsgType, payload
+//
+//   HELLO     c->s   u64 player id, the server creates the base if it's new
+//   COMMAND   c->s   u32 seq, u8 Command, i32 a, b, c as in Action
+//   ACK       c->s   u32 tick of the STATE the client just applied
+//   WELCOME   s->c   the player's base as an encoded save, tick 0
+//   RESULT    s->c   u32 seq of the command, u8 Status
+//   STATE     s->c   only what changed since the client's last acked tick,
+//                      see write_state()
+//
+// a STATE is sent only once the previous one is acked, so the client is
+//   always at its base tick when it arrives and an idle base sends nothing
+namespace net
+{
+
+enum class MsgType : uint8_t
+{
+	HELLO,
+	COMMAND,
+	WELCOME,
+	RESULT,
+	STATE,
+	ACK
+};
+
+enum class Command : uint8_t
+{
+	PLACE,		// a = building type, b = x, c = y
+	MOVE,		// a = building index, b = x, c = y
+	COLLECT,	// a = building index
+	TRAIN,
+	ATTACK
+};
+
+enum class Status : uint8_t
+{
+	OK,
+	REJECTED,		// the sim didn't allow it, the client is out of date
+	UNSUPPORTED		// the game doesn't have it yet
+};
+
+struct Hello
+{
+	uint64_t player;
+};
+
+struct CommandMsg
+{
+	uint32_t seq;
+	Command command;
+	int32_t a, b, c;
+};
+
+struct Result
+{
+	uint32_t seq;
+	Status status;
+};
+
+struct Ack
+{
+	uint32_t tick;
+};
+
+// a client's copy of its base, kept up to date by STATE messages
+struct Mirror
+{
+	uint32_t tick; // of the last STATE applied, what the client acks
+	save::Header header;
+	std::vector<uint8_t> tiles;
+	std::vector<save::BuildingRecord> buildings;
+};
+
+uint32_t const HEADER_SIZE = 5;
+uint32_t const MAX_MESSAGE = 1 << 20;
+
+// each appends one message to out
+void write_hello(std::vector<char>& out, Hello const& m);
+void write_command(std::vector<char>& out, CommandMsg const& m);
+void write_result(std::vector<char>& out, Result const& m);
+void write_ack(std::vector<char>& out, Ack const& m);
+void write_welcome(std::vector<char>& out, save::Snapshot const& snap);
+
+// cur as a delta against base, the snapshot the client acked at base_tick,
+//   with varints and only the fields that changed:
+//     varint tick, varint base tick
+//     varint mask of the changed resources, gold through troph, then a
+//       zigzag varint of new - old for each
+//     varint building count
+//     varint runs of changed tiles, each a varint gap from the end of the
+//       previous run, a varint length, then the states 2 bits each
+//     varint changed buildings, each a varint gap from the previous one, a
+//       u8 mask of the changed fields, then type and level as varints and
+//       x, y and amount as zigzag varints of new - old
+// both must have the same number of tiles
+void write_state(std::vector<char>& out, uint32_t tick, uint32_t base_tick,
+	save::Snapshot const& base, save::Snapshot const& cur);
+
+// false if nothing a client can see changed between the two
+bool state_changed(save::Snapshot const& prev, save::Snapshot const& cur);
+
+// size of the first message in data, 0 if it hasn't all arrived yet, -1 if
+//   it can't be a message
+long long message_size(char const* data, std::size_t size);
+MsgType message_type(char const* data);
+
+// data and size are one whole message, false if it's malformed
+bool read_hello(char const* data, std::size_t size, Hello& m);
+bool read_command(char const* data, std::size_t size, CommandMsg& m);
+bool read_result(char const* data, std::size_t size, Result& m);
+bool read_ack(char const* data, std::size_t size, Ack& m);
+bool read_welcome(char const* data, std::size_t size, Mirror& out);
+// applies the delta to out in place, false if it's malformed or out isn't
+//   at its base tick, out may be partly updated then and needs a new WELCOME
+bool read_state(char const* data, std::size_t size, Mirror& out);
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "depth_sort.hpp"
+#include "building_type.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// everything a frame draws, copied out of the sim at the end of a tick so
+//   the renderer never reads Base while the sim is writing it
+// the vectors keep their capacity between ticks, a steady scene copies
+//   into them without allocating
+struct RenderSnapshot
+{
+	// a building, the placement preview or a farmer, in painter's order
+	struct Sprite
+	{
+		DrawKind kind;
+		bool flag;		// building: drawn see through, preview: can be placed
+		int16_t type;	// building type, -1 for farmers
+		int x, y;		// screen position, as the sim stores it
+		int depth;		// screen y of the sprite's base, what it was sorted by
+	};
+
+	// a full production bubble over a building
+	struct Bubble
+	{
+		int16_t type;
+		int x, y;
+	};
+
+	struct Particle
+	{
+		float x, y;
+		float alpha;
+		ProdType sprite;
+	};
+
+	// "Not enough resources" floating up from a failed placement
+	struct Message
+	{
+		int x, y;
+		float alpha;
+	};
+
+	uint32_t tick;
+	uint64_t sim_ns;	// how long the tick that made it took
+
+	int gold, wheat, wood, stone, iron, gems;
+
+	bool tutorial;
+	bool placing;		// the grid and the preview's buttons are shown
+	Sprite preview;		// valid while placing
+
+	std::vector<Sprite> scene;
+	std::vector<Bubble> bubbles;
+	std::vector<Particle> particles;
+	std::vector<Message> messages;
+
+	int shop_state;		// Base::ShopState
+	int shop_y;
+};
+
+// triple buffer between one sim thread and one render thread
+// the sim fills back(), publish() swaps it with the middle buffer in one
+//   atomic exchange, and acquire() swaps the middle buffer into the front if
+//   anything new was published, neither side ever waits on the other
+// the renderer is at most one tick behind and never sees a half written tick
+class SnapshotBuffer
+{
+public:
+	SnapshotBuffer();
+
+	SnapshotBuffer(SnapshotBuffer const&) = delete;
+	void operator=(SnapshotBuffer const&) = delete;
+
+public:
+	// sim thread
+	RenderSnapshot& back();
+	void publish();
+
+	// render thread, the newest published snapshot, the same one again if
+	//   the sim hasn't published since, nullptr before the first
+	RenderSnapshot const* acquire();
+
+private:
+	// low two bits index the middle buffer, FRESH is set when it's newer
+	//   than the front
+	static int const FRESH = 4;
+
+	RenderSnapshot buffers[3];
+	std::atomic<int> middle;
+	int back_index, front_index;
+	bool any;
+};
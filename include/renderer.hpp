@@ -0,0 +1,52 @@
+#pragma once
+
+#include "render_snapshot.hpp"
+#include "particles.hpp"
+
+#include <SDL.h>
+
+#include <array>
+#include <cstdint>
+
+// draws a RenderSnapshot, the only thing on the render thread that knows
+//   what the game looks like
+// it never reads Base or Particles, so the sim can tick while a frame is
+//   being drawn
+class Renderer
+{
+public:
+	static Renderer& get();
+
+public:
+	Renderer(Renderer const&) = delete;
+	void operator=(Renderer const&) = delete;
+
+	// the whole frame except the overlay, in the order it's layered
+	void draw(RenderSnapshot const& s);
+
+	void draw_hud(RenderSnapshot const& s);
+	void draw_scene(RenderSnapshot const& s);
+	void draw_shop(RenderSnapshot const& s);
+
+private:
+	Renderer();
+
+	void draw_grid();
+	void draw_sprites(RenderSnapshot const& s);
+	void draw_particles(RenderSnapshot const& s);
+	void draw_bubbles(RenderSnapshot const& s);
+	void draw_placement_options(RenderSnapshot::Sprite const& preview);
+	void draw_messages(RenderSnapshot const& s);
+	void draw_tutorial();
+
+private:
+	static int const PROD_TYPES = 5;
+
+	// loaded on the first frame with particles, the window has to exist
+	bool sprites_loaded;
+	std::array<int, PROD_TYPES> sprite_handles;
+	std::array<SDL_Point, PROD_TYPES> sprite_dims;
+
+	std::array<SDL_FRect, Particles::CAPACITY> batch_rects;
+	std::array<uint8_t, Particles::CAPACITY> batch_alphas;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// xoshiro256**, small state and a few ns per draw
+// the same seed gives the same numbers on every platform, unlike the
+//   std distributions, so replays and server checks can be bit exact
+class Rng
+{
+public:
+	explicit Rng(uint64_t const seed = 0);
+
+	void seed(uint64_t const seed);
+
+	uint64_t next()
+	{
+		uint64_t const result = rotl(s[1] * 5, 7) * 9;
+		uint64_t const t = s[1] << 17;
+
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+
+		return result;
+	}
+
+	// inclusive
+	int range(int const lb, int const ub)
+	{
+		return lb + (int)(((next() >> 32) * (uint64_t)(ub - lb + 1)) >> 32);
+	}
+
+	// [lb, ub)
+	float uniform(float const lb, float const ub)
+	{
+		return lb + (float)(next() >> 40) * 0x1.0p-24f * (ub - lb);
+	}
+
+	void fill_range(int* out, std::size_t n, int const lb, int const ub);
+	void fill_uniform(float* out, std::size_t n, float const lb, float const ub);
+
+private:
+	static uint64_t rotl(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+private:
+	std::array<uint64_t, 4> s;
+};
+
+enum class RngStream
+{
+	PATHING,
+	PARTICLES,
+	COMBAT,
+	COUNT
+};
+
+// one independent Rng per stream, so drawing more particles never changes
+//   where the farmers walk
+class RngStreams
+{
+public:
+	explicit RngStreams(uint64_t const seed = 0);
+
+	void seed(uint64_t const seed);
+
+	Rng& operator[](RngStream const stream);
+
+private:
+	std::array<Rng, (int)RngStream::COUNT> streams;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Base;
+
+// binary save of a Base, also the format bases are sent in
+// the file is the in memory layout of these structs, little endian, so
+//   loading is a few size checks and pointer casts over a mapped file
+//
+//   Header             80 bytes
+//   tiles              tiles_x * tiles_y bytes of TileState, row major,
+//                        padded to 4
+//   BuildingRecord[]   building_count * 16 bytes
+namespace save
+{
+
+uint32_t const VERSION = 2;
+
+struct Header
+{
+	char magic[4];			// "NKSV"
+	uint32_t version;
+	uint64_t saved_at;		// unix seconds
+	uint64_t journal_seq;	// last journaled action folded into this save
+
+	int32_t gold, wheat, wood, stone, iron, gems;
+	int32_t level, exp, troph;
+
+	int32_t tiles_x, tiles_y;
+	uint32_t building_count;
+	uint32_t tiles_offset;		// from the start of the file
+	uint32_t buildings_offset;
+};
+
+struct BuildingRecord
+{
+	uint16_t type;		// index into BuildingCatalog
+	uint16_t level;
+	int32_t x, y;		// screen position, as snapped when placed
+	int32_t amount;		// produced but not yet collected
+};
+
+static_assert(sizeof(Header) == 80 && sizeof(BuildingRecord) == 16, "save structs must stay packed");
+
+// the sim state at a frame boundary, the layers are shared with the Base
+//   and it copies one only if it changes while a snapshot still holds it
+struct Snapshot
+{
+	Header header;		// magic, version and offsets are filled by encode()
+	std::shared_ptr<std::vector<uint8_t> const> tiles;
+	std::shared_ptr<std::vector<BuildingRecord> const> buildings;
+};
+
+// points into an encoded buffer, valid as long as the buffer is
+struct View
+{
+	Header const* header;
+	uint8_t const* tiles;
+	BuildingRecord const* buildings;
+};
+
+std::vector<char> encode(Snapshot const& snap);
+// false if the buffer is truncated, from another version, or has a tile
+//   state or building type out of range
+bool view(char const* data, std::size_t size, View& out);
+
+// packbits run length coding of an encoded save, grass tiles mostly vanish
+//   starts with "NKSZ" and the decoded size, load() accepts either form
+std::vector<char> compress(std::vector<char> const& bytes);
+bool decompress(char const* data, std::size_t size, std::vector<char>& out);
+
+// writes to a temporary file and renames it over path, so a crash leaves
+//   either the old save or the new one
+// with sync the file and then its directory are flushed before returning,
+//   so anything written after it can rely on the rename having landed
+// without sync a power cut can still lose it, for files that can be rebuilt
+bool write_file(std::string const& path, char const* data, std::size_t size, bool const sync = true);
+
+bool save(Base const& base, std::string const& path);
+
+// keeps the mapping open only for the length of the call
+bool load(Base& base, std::string const& path, uint64_t* journal_seq = nullptr);
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "rng.hpp"
+#include "base.hpp"
+
+#include <cstdint>
+#include <string>
+
+// a seeded stress scene for scaling tests, built straight into a Base
+struct SceneConfig
+{
+	int tiles_x = 58, tiles_y = 23;
+	int buildings = 0;
+	int villagers = 2;
+	int particles = 0;   // kept topped up by StressScene::update()
+	uint64_t seed = 1;
+};
+
+// "buildings=500,villagers=50,particles=1000,w=120,h=60,seed=3", missing
+//   keys keep their defaults
+bool parse_scene_config(std::string const& str, SceneConfig& config);
+
+class StressScene
+{
+public:
+	explicit StressScene(SceneConfig const& _config, Base& _base = Base::get());
+
+	// replaces the current base, buildings that don't fit after a few tries
+	//   are skipped so check placed_buildings()
+	void generate();
+	// once per frame, respawns particles that died
+	void update();
+
+	int placed_buildings() const;
+
+private:
+	SceneConfig config;
+	Base& base;
+	Rng rng;
+	int placed;
+};
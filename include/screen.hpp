@@ -1,12 +1,16 @@
 #pragma once
 
 #include "sdl2.hpp"
+#include "frame_arena.hpp"
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 #include <SDL_image.h>
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -23,6 +27,8 @@ public:
 	void operator=(Screen const&) = delete;
 
 	void set_window();
+	// renders into an offscreen surface with SDL's software renderer, no display needed
+	void set_headless();
 
 public:
 	void update();
@@ -47,11 +53,20 @@ public:
 
 	void text(std::string const& text, int x, int y);
 	void text(sdl2::Text const& text);
+	// sets the font, size and alignment, then draws
+	void text(std::string const& text, std::string const& font, int size, int x, int y, sdl2::TextAlign const& align);
+	// draws from glyphs rasterized once per font and size, for text that changes every frame
+	void text_cached(std::string_view text, int x, int y);
 
 	std::pair<int, int> get_img_dim(std::string const& img);
 	void image(std::string const& img, int x, int y, int w, int h, int alpha = 255);
 	void image(std::string const& img, sdl2::Dimension const& dim, int alpha = 255);
 
+	// handles skip the name lookup for sprites drawn every frame
+	int image_handle(std::string const& img);
+	std::pair<int, int> get_img_dim(int handle);
+	// draws every rect (corner aligned) with the same texture in one call
+	void image_batch(int handle, SDL_FRect const* rects, uint8_t const* alphas, int n);
 
 	void line_mode(sdl2::LineMode const& mode);
 	void rect_align(sdl2::RectAlign const& align);
@@ -61,27 +76,93 @@ public:
 	void text_size(int size);
 	void text_align(sdl2::TextAlign const& align);
 
+public:
+	// counted from the SDL calls Screen makes, reset by update()
+	struct Stats
+	{
+		// draw calls by kind
+		int64_t points, rects, copies, geometry;
+		int64_t draw_calls;
+
+		int64_t state_changes; // draw colour and texture colour/alpha mods
+		int64_t texture_binds;
+		int64_t texture_uploads;
+		int64_t text_rasterizations;
+		int64_t bytes_uploaded;
+
+		Stats& operator+=(Stats const& other);
+		Stats& operator-=(Stats const& other);
+
+		static constexpr int64_t Stats::* FIELDS[] = {
+			&Stats::points, &Stats::rects, &Stats::copies, &Stats::geometry, &Stats::draw_calls,
+			&Stats::state_changes, &Stats::texture_binds, &Stats::texture_uploads,
+			&Stats::text_rasterizations, &Stats::bytes_uploaded
+		};
+		static constexpr char const* FIELD_NAMES[] = {
+			"points", "rects", "copies", "geometry", "draw_calls",
+			"state_changes", "texture_binds", "texture_uploads",
+			"text_rasterizations", "bytes_uploaded"
+		};
+	};
+
+	Stats const& last_frame_stats() const;
+	// averaged over the last STATS_WINDOW frames, e.g. average_stats(&Screen::Stats::draw_calls)
+	double average_stats(int64_t Stats::* field) const;
+	// so debug overlays don't show up in the numbers they display
+	void pause_stats(bool const paused);
+
 public:
 	int const SCREEN_WIDTH,
 			  SCREEN_HEIGHT;
 
+	static constexpr int STATS_WINDOW = 60;
+
 private:
 	Screen();
 
-	// returns array of points on a line
+	// returns array of points on a line, allocated from the frame arena
+	//   so it's only valid until update()
 	// fill_dir: 0 - left, 1 - right
-	std::vector<SDL_Point> line_arr(int x0, int y0, int x1, int y1);
+	frame_vector<SDL_Point> line_arr(int x0, int y0, int x1, int y1);
 
 	SDL_Rect rect_align_coords(sdl2::RectAlign align, int x, int y, int w = -1, int h = -1) const;
 
 	void line_aliase(int x0, int y0, int x1, int y1);
 	void line_antialiase(int x0, int y0, int x1, int y1);
 
+	void render_point(int x, int y);
+	void render_rect(SDL_Rect const& rect, bool const filled);
+	void render_copy(SDL_Texture* texture, SDL_Rect const& rect);
+	void count_texture(SDL_Texture* texture);
+	void render_color(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	void render_texture_mod(SDL_Texture* texture, SDL_Color const& clr);
+	SDL_Texture* upload(SDL_Surface* surface);
+	void count(int64_t Stats::* field, int64_t n = 1);
+
+	struct GlyphSet
+	{
+		std::string font;
+		int size;
+		int h;
+		std::array<sdl2::texture_ptr, 95> glyphs; // printable ascii
+		std::array<int, 95> w;
+	};
+
+	GlyphSet& glyph_set(std::string const& font, int size);
+
 private:
 	sdl2::window_ptr window;
+	sdl2::surface_ptr headless_surface;
 	sdl2::renderer_ptr renderer;
 
 	std::unordered_map<std::string, sdl2::texture_ptr> images;
+	std::unordered_map<std::string, int> image_handles;
+	std::vector<SDL_Texture*> handle_textures;
+
+	std::vector<SDL_Vertex> batch_vertices;
+	std::vector<int> batch_indices;
+
+	std::vector<std::unique_ptr<GlyphSet>> glyph_sets;
 
 	SDL_Color fill_clr;
 	SDL_Color stroke_clr;
@@ -92,10 +173,18 @@ private:
 	sdl2::RectAlign m_rect_align;
 	sdl2::ImageAlign m_image_align;
 	sdl2::TextAlign m_text_align;
-	std::string m_text_font;
-
 	std::string m_text_font;
 	int m_text_size;
 
+	Stats stats, prev_stats;
+	std::array<Stats, STATS_WINDOW> stats_window;
+	Stats window_sum;
+	int window_head, window_count;
+	bool stats_paused;
+
+	SDL_Texture* bound_texture;
+	SDL_Color draw_clr;
+	bool draw_clr_valid;
+
 	// StrokeAlign stroke_align;
 };
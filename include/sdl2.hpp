@@ -5,7 +5,6 @@
 
 #include <memory>
 #include <string>
-#include <random>
 
 namespace sdl2
 {
@@ -28,14 +27,6 @@ using texture_ptr  = std::unique_ptr<SDL_Texture,  SDL_Deleter>;
 using font_ptr = std::unique_ptr<TTF_Font, SDL_Deleter>;
 
 
-
-
-// inclusive
-int rand_int(int const lb, int const ub);
-// inclusive, 1 decial place
-double rand_dbl(double const lb, double const ub);
-
-
 // text fonts, colours, and alignment
 
 enum class LineMode
@@ -83,21 +74,6 @@ struct Dimension
 	int x, y, w, h;
 };
 
-struct Text
-{
-	Text(sdl2::renderer_ptr& renderer, std::string const& _text, int _x, int _y, SDL_Color _clr, std::string const& _font, int _size, TextAlign _align);
-	bool clicked_on(int mx, int my) const;
-
-	std::string txt;
-	int x, y;
-	SDL_Color clr;
-	std::string font;
-	int size;
-	RectAlign align;
-
-	sdl2::texture_ptr texture;
-};
-
 std::string const str_brygada = "../assets/brygada.ttf";
 SDL_Color const clr_black{ 0, 0, 0, 255 };
 SDL_Color const clr_yellow{ 255, 239, 0, 255 };
@@ -107,4 +83,20 @@ SDL_Color const clr_clear{ 0, 0, 0, 0 };
 SDL_Color const clr_red{ 255, 50, 50, 150 };
 SDL_Color const clr_gray{ 240, 240, 240, 170 };
 
+// a line of text placed on screen, measured once so it can be hit tested
+//   without a renderer, drawn with Screen::text
+struct Text
+{
+	Text(std::string const& _text, int _x, int _y, TextAlign _align,
+		SDL_Color _clr = clr_white, std::string const& _font = str_brygada, int _size = 45);
+	bool clicked_on(int mx, int my) const;
+
+	std::string text;
+	Dimension dim;
+	SDL_Color clr;
+	std::string font;
+	int size;
+	TextAlign align;
+};
+
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// every base a server hosts, each with its own tiles, buildings, farmers and
+//   random streams, ticked together in batches as jobs
+// bases don't touch each other, so a batch needs no locking, but between
+//   ticks only one thread may use them
+class World
+{
+public:
+	World();
+
+	World(World const&) = delete;
+	void operator=(World const&) = delete;
+
+public:
+	// a new headless base seeded with its id, or the one that's already there
+	Base& add(uint64_t const id);
+	// nullptr if there's no such base
+	Base* find(uint64_t const id);
+
+	int size() const;
+
+	// on_action of a base is called from whichever worker ticks it
+	void tick(bool second);
+
+public:
+	static int const BATCH = 16;
+
+private:
+	std::vector<std::unique_ptr<Base>> bases;
+	std::unordered_map<uint64_t, Base*> by_id;
+};
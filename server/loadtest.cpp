@@ -0,0 +1,531 @@
+// load generator, runs a server and thousands of scripted clients in one
+//   process over loopback and reports what the server could keep up with
+// usage: kingdom_loadtest [--clients <n>] [--seconds <s>] [--ramp <s>] [--think <ms>]
+//                         [--mix collect=<n>,place=<n>,attack=<n>] [--seed <n>]
+//                         [--listen tcp:<port>|unix:<path>] [--tick <ms>]
+//                         [--threads <n>] [--stats <ms>] [--store <dir>]
+//   --clients connect evenly over --ramp seconds, then each sends a command
+//   about every --think ms for --seconds, picking from --mix by weight
+//   every client's player id and dice rolls come from --seed, but what a
+//   roll turns into is aimed at the client's mirror of its base, which
+//   depends on which STATEs arrived when, so two runs with the same flags
+//   send the same mix of commands, not the same commands
+//   attacks are only matched against rivals with --store, which every
+//   client's base is put in when it first connects
+//   prints one json object per command kind and one for the server, its
+//   kb_per_client is a base plus both ends of its connection, the clients
+//   run in the same process
+// run it from build/ like the game so data files resolve
+
+#include "server.hpp"
+#include "protocol.hpp"
+#include "building_type.hpp"
+#include "profiler.hpp"
+#include "jobs.hpp"
+#include "rng.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+// the commands a client picks from, as indices into Config::mix and the report
+enum Kind
+{
+	COLLECT,
+	PLACE,
+	ATTACK,
+	KINDS
+};
+
+char const* const KIND_NAMES[KINDS] = { "collect", "place", "attack" };
+
+struct Config
+{
+	int clients = 1000;
+	int seconds = 30;
+	int ramp = 5;
+	int think_ms = 1000;
+	int mix[KINDS] = { 60, 30, 10 };
+	uint64_t seed = 1;
+	std::string address = "tcp:7878";
+	int tick_ms = 100;
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+	int stats_ms = 0;
+	std::string store_dir;
+};
+
+// "collect=6,place=3,attack=1", missing kinds keep their weight
+bool parse_mix(std::string const& str, int (&mix)[KINDS])
+{
+	std::stringstream ss(str);
+	std::string item;
+	while (std::getline(ss, item, ','))
+	{
+		auto const eq = item.find('=');
+		int kind = 0;
+		while (kind < KINDS && (eq == std::string::npos || item.compare(0, eq, KIND_NAMES[kind]) != 0))
+			kind++;
+
+		if (kind == KINDS)
+		{
+			std::cout << "[error] - unknown mix entry '" << item << "'\n";
+			return false;
+		}
+
+		mix[kind] = std::max(0, std::atoi(item.c_str() + eq + 1));
+	}
+
+	return true;
+}
+
+// one virtual player, a socket and what it thinks its base looks like
+struct Client
+{
+	struct Pending
+	{
+		uint32_t seq;
+		Kind kind;
+		uint64_t sent_ns;
+	};
+
+	int fd = -1;
+	uint64_t player = 0;
+	Rng rng;
+
+	std::vector<char> in, out;
+	net::Mirror mirror{};
+	bool welcomed = false;
+
+	uint32_t seq = 0;
+	uint64_t next_ns = 0;
+	std::vector<Pending> pending;
+};
+
+struct Report
+{
+	std::vector<uint64_t> latency_ns[KINDS];
+	uint64_t statuses[KINDS][3] = {};
+	uint64_t states = 0, bad_states = 0, dropped = 0;
+};
+
+int connect_to(std::string const& address)
+{
+	int fd = -1;
+	if (address.rfind("tcp:", 0) == 0)
+	{
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)std::atoi(address.c_str() + 4));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (fd != -1 && connect(fd, (sockaddr*)&addr, sizeof(addr)) == -1)
+		{
+			close(fd);
+			return -1;
+		}
+
+		int const one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	}
+	else
+	{
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		std::strncpy(addr.sun_path, address.c_str() + 5, sizeof(addr.sun_path) - 1);
+		if (fd != -1 && connect(fd, (sockaddr*)&addr, sizeof(addr)) == -1)
+		{
+			close(fd);
+			return -1;
+		}
+	}
+
+	if (fd != -1)
+	{
+		int const flags = fcntl(fd, F_GETFL, 0);
+		fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	}
+
+	return fd;
+}
+
+// false once the connection is gone
+bool flush(Client& c)
+{
+	std::size_t off = 0;
+	while (off < c.out.size())
+	{
+		ssize_t const n = send(c.fd, c.out.data() + off, c.out.size() - off, 0);
+		if (n > 0)
+			off += n;
+		else if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		else if (errno != EINTR)
+			return false;
+	}
+
+	c.out.erase(c.out.begin(), c.out.begin() + off);
+	return true;
+}
+
+// the player's next move, weighted by the mix and aimed at its mirror
+void act(Client& c, Config const& config, uint64_t now)
+{
+	int total = 0;
+	for (int w : config.mix)
+		total += w;
+
+	int roll = c.rng.range(0, std::max(1, total) - 1);
+	int kind = 0;
+	while (kind < KINDS - 1 && roll >= config.mix[kind])
+		roll -= config.mix[kind++];
+
+	// nothing to collect from yet, so build something first
+	if (kind == COLLECT && c.mirror.buildings.empty())
+		kind = PLACE;
+
+	net::CommandMsg m{ ++c.seq, net::Command::COLLECT, 0, 0, 0 };
+	switch (kind)
+	{
+	case COLLECT:
+	{
+		// the fullest building, like a player would
+		auto const& b = c.mirror.buildings;
+		int best = c.rng.range(0, (int)b.size() - 1);
+		for (int i = 0; i < (int)b.size(); ++i)
+		{
+			if (b[i].amount > b[best].amount)
+				best = i;
+		}
+
+		m.command = net::Command::COLLECT;
+		m.a = best;
+		break;
+	}
+	case PLACE:
+		m.command = net::Command::PLACE;
+		m.a = c.rng.range(0, BuildingCatalog::get().size() - 1);
+		m.b = 5 + 20 * c.rng.range(0, std::max(1, c.mirror.header.tiles_x) - 1);
+		m.c = 60 + 20 * c.rng.range(0, std::max(1, c.mirror.header.tiles_y) - 1);
+		break;
+	case ATTACK:
+		m.command = net::Command::ATTACK;
+		break;
+	}
+
+	net::write_command(c.out, m);
+	c.pending.push_back(Client::Pending{ m.seq, (Kind)kind, now });
+
+	// jittered so clients that connected together drift apart
+	c.next_ns = now + (uint64_t)c.rng.range(config.think_ms / 2, config.think_ms * 3 / 2) * 1000000;
+}
+
+// false once the client should be dropped
+bool read_messages(Client& c, Config const& config, Report& report)
+{
+	char buf[16384];
+	while (true)
+	{
+		ssize_t const n = recv(c.fd, buf, sizeof(buf), 0);
+		if (n > 0)
+		{
+			c.in.insert(c.in.end(), buf, buf + n);
+			continue;
+		}
+
+		if (n == 0)
+			return false;
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		if (errno != EINTR)
+			return false;
+	}
+
+	uint64_t const now = prof::now_ns();
+	std::size_t off = 0;
+	while (true)
+	{
+		long long const size = net::message_size(c.in.data() + off, c.in.size() - off);
+		if (size < 0)
+			return false;
+		if (size == 0)
+			break;
+
+		char const* data = c.in.data() + off;
+		switch (net::message_type(data))
+		{
+		case net::MsgType::WELCOME:
+			if (!net::read_welcome(data, size, c.mirror))
+				return false;
+
+			c.welcomed = true;
+			c.next_ns = now + (uint64_t)c.rng.range(0, config.think_ms) * 1000000;
+			break;
+		case net::MsgType::STATE:
+			report.states++;
+			if (!net::read_state(data, size, c.mirror))
+			{
+				report.bad_states++;
+				return false;
+			}
+
+			net::write_ack(c.out, net::Ack{ c.mirror.tick });
+			break;
+		case net::MsgType::RESULT:
+		{
+			net::Result r;
+			if (!net::read_result(data, size, r))
+				return false;
+
+			auto const it = std::find_if(c.pending.begin(), c.pending.end(),
+				[&](Client::Pending const& p) { return p.seq == r.seq; });
+			if (it != c.pending.end())
+			{
+				report.latency_ns[it->kind].push_back(now - it->sent_ns);
+				report.statuses[it->kind][std::min((int)r.status, 2)]++;
+				c.pending.erase(it);
+			}
+			break;
+		}
+		default:
+			return false;
+		}
+
+		off += size;
+	}
+
+	c.in.erase(c.in.begin(), c.in.begin() + off);
+	return true;
+}
+
+// secs is how long commands were timed for, run_secs the whole run the
+//   server totals cover
+void print_report(Config const& config, Report& report, Server::Totals const& totals,
+	double secs, double run_secs, int players, std::size_t client_bytes)
+{
+	std::size_t commands = 0;
+	for (auto const& lat : report.latency_ns)
+		commands += lat.size();
+
+	for (int k = 0; k < KINDS; ++k)
+	{
+		auto& lat = report.latency_ns[k];
+		std::sort(lat.begin(), lat.end());
+		auto pct = [&](double p) { return lat.empty() ? 0.0 : lat[std::min(lat.size() - 1, (std::size_t)(p * lat.size()))] / 1e6; };
+
+		std::printf("{\"name\": \"loadtest/%s\", \"count\": %zu, \"per_s\": %.1f, \"ok\": %llu, \"rejected\": %llu, "
+			"\"unsupported\": %llu, \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}\n",
+			KIND_NAMES[k], lat.size(), lat.size() / secs,
+			(unsigned long long)report.statuses[k][0], (unsigned long long)report.statuses[k][1],
+			(unsigned long long)report.statuses[k][2], pct(0.5), pct(0.9), pct(0.99), lat.empty() ? 0.0 : lat.back() / 1e6);
+	}
+
+	uint64_t const ticks = std::max<uint64_t>(1, totals.ticks);
+	std::printf("{\"name\": \"loadtest/server\", \"seed\": %llu, \"clients\": %d, \"players\": %d, \"threads\": %d, "
+		"\"tick_ms\": %d, \"ticks\": %llu, \"tick_mean_ms\": %.3f, \"tick_max_ms\": %.3f, \"sim_mean_ms\": %.3f, "
+		"\"commands_per_s\": %.1f, \"states\": %llu, \"bad_states\": %llu, \"dropped\": %llu, "
+		"\"in_kb_per_s\": %.2f, \"out_kb_per_s\": %.2f, \"kb_per_client\": %.1f}\n",
+		(unsigned long long)config.seed, config.clients, players, Jobs::get().size(), config.tick_ms,
+		(unsigned long long)totals.ticks, totals.tick_ns / 1e6 / ticks, totals.tick_max_ns / 1e6, totals.sim_ns / 1e6 / ticks,
+		commands / secs, (unsigned long long)report.states, (unsigned long long)report.bad_states,
+		(unsigned long long)report.dropped, totals.bytes_in / 1024.0 / run_secs, totals.bytes_out / 1024.0 / run_secs,
+		players > 0 ? client_bytes / 1024.0 / players : 0.0);
+	std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	Config config;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--clients") == 0 && i + 1 < argc)
+			config.clients = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			config.seconds = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--ramp") == 0 && i + 1 < argc)
+			config.ramp = std::max(0, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--think") == 0 && i + 1 < argc)
+			config.think_ms = std::max(2, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--mix") == 0 && i + 1 < argc)
+		{
+			if (!parse_mix(argv[++i], config.mix))
+				return 1;
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			config.seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--listen") == 0 && i + 1 < argc)
+			config.address = argv[++i];
+		else if (std::strcmp(argv[i], "--tick") == 0 && i + 1 < argc)
+			config.tick_ms = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			config.threads = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
+			config.stats_ms = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--store") == 0 && i + 1 < argc)
+			config.store_dir = argv[++i];
+	}
+
+	// both ends of every connection are in this process
+	rlimit files;
+	if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max)
+	{
+		files.rlim_cur = files.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &files);
+	}
+
+	std::signal(SIGPIPE, SIG_IGN);
+
+	// the clients get this thread, the server and its workers the rest
+	Jobs::get().start(config.threads - 1);
+
+	Server server(config.tick_ms);
+	if (!server.listen(config.address))
+		return 1;
+	if (!config.store_dir.empty() && !server.open_store(config.store_dir))
+		return 1;
+	server.set_stats_interval(config.stats_ms);
+
+	std::size_t const rss_start = resident_bytes();
+	std::thread server_thread([&] { server.run(); });
+
+	Rng ids(config.seed);
+	std::vector<std::unique_ptr<Client>> clients(config.clients);
+	for (auto& c : clients)
+	{
+		c = std::make_unique<Client>();
+		c->player = ids.next();
+		c->rng.seed(ids.next());
+	}
+
+	Report report;
+	std::vector<pollfd> fds;
+	std::vector<Client*> polled;
+
+	uint64_t const start = prof::now_ns();
+	uint64_t const ramp_ns = (uint64_t)config.ramp * 1000000000;
+	uint64_t const end = start + ramp_ns + (uint64_t)config.seconds * 1000000000;
+	uint64_t const drain_end = end + 2000000000ull;
+	uint64_t measure_start = 0;
+	std::size_t rss_ramped = 0;
+	int connected = 0;
+
+	while (true)
+	{
+		uint64_t const now = prof::now_ns();
+		if (now >= drain_end)
+			break;
+
+		// connect evenly over the ramp
+		int const due = ramp_ns == 0 ? config.clients
+			: (int)std::min<uint64_t>(config.clients, (now - start) * config.clients / ramp_ns + 1);
+		for (; connected < due; ++connected)
+		{
+			auto& c = *clients[connected];
+			c.fd = connect_to(config.address);
+			if (c.fd == -1)
+			{
+				std::cout << "[error] - client " << connected << " could not connect: " << std::strerror(errno) << '\n';
+				report.dropped++;
+				continue;
+			}
+
+			net::write_hello(c.out, net::Hello{ c.player });
+		}
+
+		// commands are only timed once every base exists, after the ramp
+		if (measure_start == 0 && connected == config.clients && now >= start + ramp_ns)
+		{
+			measure_start = now;
+			rss_ramped = resident_bytes();
+			for (auto& l : report.latency_ns)
+				l.clear();
+			std::memset(report.statuses, 0, sizeof(report.statuses));
+		}
+
+		uint64_t next = std::min(drain_end, now + 10000000);
+		fds.clear();
+		polled.clear();
+		for (auto& c : clients)
+		{
+			if (c->fd == -1)
+				continue;
+
+			if (c->welcomed && now < end && now >= c->next_ns)
+				act(*c, config, now);
+			if (c->welcomed && now < end)
+				next = std::min(next, c->next_ns);
+
+			fds.push_back(pollfd{ c->fd, (short)(POLLIN | (c->out.empty() ? 0 : POLLOUT)), 0 });
+			polled.push_back(c.get());
+		}
+
+		uint64_t const wait_ns = next > prof::now_ns() ? next - prof::now_ns() : 0;
+		if (poll(fds.data(), fds.size(), (int)(wait_ns / 1000000)) <= 0)
+			continue;
+
+		for (std::size_t i = 0; i < fds.size(); ++i)
+		{
+			auto& c = *polled[i];
+			short const ev = fds[i].revents;
+
+			bool ok = !(ev & (POLLERR | POLLNVAL));
+			if (ok && (ev & (POLLIN | POLLHUP)))
+				ok = read_messages(c, config, report);
+			if (ok && !c.out.empty())
+				ok = flush(c);
+
+			if (!ok)
+			{
+				close(c.fd);
+				c.fd = -1;
+				report.dropped++;
+			}
+		}
+	}
+
+	double const secs = measure_start == 0 ? 1.0 : (std::min(prof::now_ns(), end) - measure_start) / 1e9;
+	double const run_secs = (prof::now_ns() - start) / 1e9;
+
+	for (auto& c : clients)
+	{
+		if (c->fd != -1)
+			close(c->fd);
+	}
+
+	server.stop();
+	server_thread.join();
+
+	// what the bases, their connections and the clients' mirrors cost,
+	//   measured at the end of the ramp
+	std::size_t const client_bytes = rss_ramped > rss_start ? rss_ramped - rss_start : 0;
+	print_report(config, report, server.get_totals(), secs, run_secs, server.player_count(), client_bytes);
+
+	return report.bad_states > 0 ? 1 : 0;
+}
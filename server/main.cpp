@@ -0,0 +1,81 @@
+// headless authoritative server for local testing
+// usage: kingdom_server [--listen tcp:<port>|unix:<path>] [--tick <ms>] [--threads <n>]
+//                       [--stats <ms>] [--store <dir>] [--profile <file>]
+//   --threads is how many cores tick bases, all of them by default
+//   --store keeps every player's base in dir for attacks to be matched
+//   against, without it ATTACK is unsupported
+//   --stats prints one json object per interval with tick time, sim cost per
+//   player, command rate, bandwidth and resident memory
+// run it from build/ like the game so data files resolve
+
+#include "server.hpp"
+#include "profiler.hpp"
+#include "jobs.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+Server* running = nullptr;
+
+void on_signal(int)
+{
+	if (running)
+		running->stop();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::string address = "tcp:7777", store_dir, trace_path;
+	int tick_ms = 100, stats_ms = 0;
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--listen") == 0 && i + 1 < argc)
+			address = argv[++i];
+		else if (std::strcmp(argv[i], "--tick") == 0 && i + 1 < argc)
+			tick_ms = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
+			stats_ms = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--store") == 0 && i + 1 < argc)
+			store_dir = argv[++i];
+		else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+			trace_path = argv[++i];
+	}
+
+	prof::set_enabled(!trace_path.empty());
+
+	// the thread running the server ticks bases too
+	Jobs::get().start(threads - 1);
+
+	Server server(tick_ms);
+	if (!server.listen(address))
+		return 1;
+	if (!store_dir.empty() && !server.open_store(store_dir))
+		return 1;
+	server.set_stats_interval(stats_ms);
+
+	// a client hanging up mid send is an error from send(), not a signal
+	std::signal(SIGPIPE, SIG_IGN);
+	running = &server;
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+
+	server.run();
+
+	running = nullptr;
+	if (!trace_path.empty())
+		prof::write_chrome_trace(trace_path);
+
+	return 0;
+}
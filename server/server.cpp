@@ -0,0 +1,485 @@
+#include "server.hpp"
+#include "base.hpp"
+#include "action.hpp"
+#include "protocol.hpp"
+#include "profiler.hpp"
+#include "jobs.hpp"
+#include "base_store.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+// a client that doesn't read its states is dropped rather than buffered forever
+std::size_t const MAX_OUT = 4 << 20;
+
+bool set_nonblocking(int fd)
+{
+	int const flags = fcntl(fd, F_GETFL, 0);
+	return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+}
+
+std::size_t resident_bytes()
+{
+	FILE* file = std::fopen("/proc/self/statm", "r");
+	if (file == nullptr)
+		return 0;
+
+	unsigned long size = 0, resident = 0;
+	if (std::fscanf(file, "%lu %lu", &size, &resident) != 2)
+		resident = 0;
+	std::fclose(file);
+
+	return (std::size_t)resident * sysconf(_SC_PAGESIZE);
+}
+
+Server::Server(int const _tick_ms)
+	: tick_ms(_tick_ms), listen_fd(-1), stopping(false), match_rng(1), ticks(0)
+	, stats_ms(0), stats_start_ns(prof::now_ns()), tick_ns(0), tick_max_ns(0), sim_ns(0)
+	, stats_ticks(0), commands(0), bytes_in(0), bytes_out(0), totals{}
+{
+
+}
+
+Server::~Server()
+{
+	for (auto& c : clients)
+		close(c->fd);
+
+	if (listen_fd != -1)
+		close(listen_fd);
+	if (!unix_path.empty())
+		unlink(unix_path.c_str());
+}
+
+bool Server::listen(std::string const& address)
+{
+	if (address.rfind("tcp:", 0) == 0)
+	{
+		listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (listen_fd == -1)
+		{
+			std::cout << "[error] - could not create socket: " << std::strerror(errno) << '\n';
+			return false;
+		}
+
+		int const one = 1;
+		setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+		// loopback only, nothing here is ready for the internet
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)std::atoi(address.c_str() + 4));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) == -1)
+		{
+			std::cout << "[error] - could not bind " << address << ": " << std::strerror(errno) << '\n';
+			return false;
+		}
+	}
+	else if (address.rfind("unix:", 0) == 0)
+	{
+		sockaddr_un addr{};
+		if (address.size() - 5 >= sizeof(addr.sun_path))
+		{
+			std::cout << "[error] - socket path too long '" << address << "'\n";
+			return false;
+		}
+
+		listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listen_fd == -1)
+		{
+			std::cout << "[error] - could not create socket: " << std::strerror(errno) << '\n';
+			return false;
+		}
+
+		addr.sun_family = AF_UNIX;
+		std::strcpy(addr.sun_path, address.c_str() + 5);
+
+		// a stale socket from a killed server would fail the bind
+		unlink(addr.sun_path);
+		if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) == -1)
+		{
+			std::cout << "[error] - could not bind " << address << ": " << std::strerror(errno) << '\n';
+			return false;
+		}
+		unix_path = addr.sun_path;
+	}
+	else
+	{
+		std::cout << "[error] - address should be tcp:<port> or unix:<path>, not '" << address << "'\n";
+		return false;
+	}
+
+	if (::listen(listen_fd, 1024) == -1 || !set_nonblocking(listen_fd))
+	{
+		std::cout << "[error] - could not listen on " << address << ": " << std::strerror(errno) << '\n';
+		return false;
+	}
+
+	return true;
+}
+
+bool Server::open_store(std::string const& dir)
+{
+	store = std::make_unique<BaseStore>();
+	if (!store->open(dir))
+	{
+		store = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+void Server::run()
+{
+	uint64_t next_tick = prof::now_ns();
+	std::vector<pollfd> fds;
+
+	while (!stopping.load(std::memory_order_relaxed))
+	{
+		uint64_t const now = prof::now_ns();
+		if (now >= next_tick)
+		{
+			tick();
+
+			// a slow tick is dropped rather than caught up on
+			next_tick += (uint64_t)tick_ms * 1000000;
+			if (next_tick < now)
+				next_tick = now + (uint64_t)tick_ms * 1000000;
+		}
+
+		fds.clear();
+		fds.push_back(pollfd{ listen_fd, POLLIN, 0 });
+		for (auto const& c : clients)
+			fds.push_back(pollfd{ c->fd, (short)(POLLIN | (c->out.empty() ? 0 : POLLOUT)), 0 });
+
+		uint64_t const wait_ns = next_tick > prof::now_ns() ? next_tick - prof::now_ns() : 0;
+		if (poll(fds.data(), fds.size(), (int)(wait_ns / 1000000)) <= 0)
+			continue;
+
+		if (fds[0].revents & POLLIN)
+			accept_clients();
+
+		// backwards so dropping doesn't shift the clients still to go
+		for (std::size_t i = fds.size() - 1; i >= 1; --i)
+		{
+			auto& c = *clients[i - 1];
+			short const ev = fds[i].revents;
+
+			bool ok = !(ev & (POLLERR | POLLNVAL));
+			if (ok && (ev & (POLLIN | POLLHUP)))
+				ok = read_client(c);
+			if (ok && !c.out.empty())
+				ok = flush_client(c);
+
+			if (!ok)
+				drop_client(i - 1);
+		}
+	}
+}
+
+void Server::stop()
+{
+	stopping.store(true, std::memory_order_relaxed);
+}
+
+void Server::set_stats_interval(int const _stats_ms)
+{
+	stats_ms = _stats_ms;
+}
+
+int Server::player_count() const
+{
+	return players.size();
+}
+
+int Server::client_count() const
+{
+	return clients.size();
+}
+
+Server::Totals const& Server::get_totals() const
+{
+	return totals;
+}
+
+void Server::accept_clients()
+{
+	while (true)
+	{
+		int const fd = accept(listen_fd, nullptr, nullptr);
+		if (fd == -1)
+			return;
+
+		if (!set_nonblocking(fd))
+		{
+			close(fd);
+			continue;
+		}
+
+		// commands are tiny and latency is what's measured
+		int const one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		clients.push_back(std::make_unique<Client>(Client{ fd, {}, {}, nullptr, {}, {}, 0, 0, false }));
+	}
+}
+
+bool Server::read_client(Client& c)
+{
+	char buf[16384];
+	while (true)
+	{
+		ssize_t const n = recv(c.fd, buf, sizeof(buf), 0);
+		if (n > 0)
+		{
+			c.in.insert(c.in.end(), buf, buf + n);
+			bytes_in += n;
+			totals.bytes_in += n;
+			continue;
+		}
+
+		if (n == 0)
+			return false;
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		if (errno != EINTR)
+			return false;
+	}
+
+	std::size_t off = 0;
+	while (true)
+	{
+		long long const size = net::message_size(c.in.data() + off, c.in.size() - off);
+		if (size < 0)
+			return false;
+		if (size == 0)
+			break;
+
+		if (!handle_message(c, c.in.data() + off, size))
+			return false;
+		off += size;
+	}
+
+	c.in.erase(c.in.begin(), c.in.begin() + off);
+	return true;
+}
+
+bool Server::handle_message(Client& c, char const* data, std::size_t size)
+{
+	switch (net::message_type(data))
+	{
+	case net::MsgType::HELLO:
+	{
+		net::Hello m;
+		if (!net::read_hello(data, size, m) || c.player != nullptr)
+			return false;
+
+		auto& p = players[m.player];
+		if (!p)
+		{
+			p = std::make_unique<Player>(Player{ m.player, &world.add(m.player), false });
+
+			// so the next player has someone to attack
+			if (store)
+				store->put(p->id, p->base->snapshot());
+		}
+
+		// one connection per player, a second one is refused
+		if (p->connected)
+			return false;
+
+		p->connected = true;
+		c.player = p.get();
+		c.acked = p->base->snapshot();
+		c.acked_tick = 0;
+		c.in_flight = false;
+		net::write_welcome(c.out, c.acked);
+		return true;
+	}
+	case net::MsgType::COMMAND:
+	{
+		net::CommandMsg m;
+		if (!net::read_command(data, size, m) || c.player == nullptr)
+			return false;
+
+		commands++;
+		totals.commands++;
+		net::write_result(c.out, net::Result{ m.seq, handle_command(*c.player, m) });
+		return true;
+	}
+	case net::MsgType::ACK:
+	{
+		net::Ack m;
+		if (!net::read_ack(data, size, m) || !c.in_flight || m.tick != c.sent_tick)
+			return false;
+
+		c.acked = std::move(c.sent);
+		c.acked_tick = c.sent_tick;
+		c.in_flight = false;
+		return true;
+	}
+	default:
+		// the rest only go to clients
+		return false;
+	}
+}
+
+net::Status Server::handle_command(Player& p, net::CommandMsg const& m)
+{
+	PROFILE_SCOPE("Server::handle_command");
+
+	Action action{ ActionType::PLACE, m.a, m.b, m.c };
+	switch (m.command)
+	{
+	case net::Command::PLACE:
+		action.type = ActionType::PLACE;
+		break;
+	case net::Command::MOVE:
+		action.type = ActionType::MOVE;
+		break;
+	case net::Command::COLLECT:
+		action.type = ActionType::COLLECT;
+		break;
+	case net::Command::ATTACK:
+	{
+		if (!store)
+			return net::Status::UNSUPPORTED;
+
+		// there's no battle to run yet, finding the opponent is the whole attack
+		BaseStore::Rival rival;
+		return store->find_opponent(p.base->troph, p.id, match_rng, rival) ? net::Status::OK : net::Status::REJECTED;
+	}
+	case net::Command::TRAIN:
+		// there are troop stats but no army to train them into yet
+		return net::Status::UNSUPPORTED;
+	}
+
+	return p.base->perform(action) ? net::Status::OK : net::Status::REJECTED;
+}
+
+bool Server::flush_client(Client& c)
+{
+	std::size_t off = 0;
+	while (off < c.out.size())
+	{
+		ssize_t const n = send(c.fd, c.out.data() + off, c.out.size() - off, 0);
+		if (n > 0)
+		{
+			off += n;
+			continue;
+		}
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		if (errno != EINTR)
+			return false;
+	}
+
+	bytes_out += off;
+	totals.bytes_out += off;
+	c.out.erase(c.out.begin(), c.out.begin() + off);
+	return c.out.size() <= MAX_OUT;
+}
+
+void Server::drop_client(std::size_t i)
+{
+	// the base stays, it keeps producing while the player is away, and its
+	//   stored copy is what they're attacked with
+	if (auto* p = clients[i]->player)
+	{
+		p->connected = false;
+		if (store)
+			store->put(p->id, p->base->snapshot());
+	}
+
+	close(clients[i]->fd);
+	clients.erase(clients.begin() + i);
+}
+
+void Server::tick()
+{
+	PROFILE_SCOPE("Server::tick");
+
+	uint64_t const start = prof::now_ns();
+
+	ticks++;
+	bool const second = ticks % std::max(1, 1000 / tick_ms) == 0;
+
+	world.tick(second);
+
+	uint64_t const sim_end = prof::now_ns();
+
+	for (auto& c : clients)
+	{
+		// a slow client gets fewer, bigger deltas instead of a backlog
+		if (c->player == nullptr || c->in_flight)
+			continue;
+
+		auto cur = c->player->base->snapshot();
+		if (net::state_changed(c->acked, cur))
+		{
+			net::write_state(c->out, ticks, c->acked_tick, c->acked, cur);
+			c->sent = std::move(cur);
+			c->sent_tick = ticks;
+			c->in_flight = true;
+		}
+	}
+
+	uint64_t const end = prof::now_ns();
+	tick_ns += end - start;
+	tick_max_ns = std::max(tick_max_ns, end - start);
+	sim_ns += sim_end - start;
+	stats_ticks++;
+
+	totals.ticks++;
+	totals.tick_ns += end - start;
+	totals.tick_max_ns = std::max(totals.tick_max_ns, end - start);
+	totals.sim_ns += sim_end - start;
+
+	if (stats_ms > 0 && end - stats_start_ns >= (uint64_t)stats_ms * 1000000)
+		print_stats();
+}
+
+void Server::print_stats()
+{
+	uint64_t const now = prof::now_ns();
+	double const secs = (now - stats_start_ns) / 1e9;
+	int const n = std::max(1, stats_ticks);
+
+	std::printf("{\"players\": %zu, \"clients\": %zu, \"threads\": %d, \"ticks\": %d, \"tick_ms\": %.3f, \"tick_max_ms\": %.3f, "
+		"\"sim_core_us_per_player\": %.3f, \"commands_per_s\": %.1f, \"in_kb_per_s\": %.2f, \"out_kb_per_s\": %.2f, "
+		"\"rss_mb\": %.1f}\n",
+		players.size(), clients.size(), Jobs::get().size(), stats_ticks, tick_ns / 1e6 / n, tick_max_ns / 1e6,
+		players.empty() ? 0.0 : sim_ns / 1e3 / n / players.size() * Jobs::get().size(), commands / secs,
+		bytes_in / 1024.0 / secs, bytes_out / 1024.0 / secs, resident_bytes() / (1024.0 * 1024.0));
+	std::fflush(stdout);
+
+	stats_start_ns = now;
+	tick_ns = tick_max_ns = sim_ns = 0;
+	stats_ticks = commands = 0;
+	bytes_in = bytes_out = 0;
+}
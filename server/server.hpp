@@ -0,0 +1,117 @@
+#pragma once
+
+#include "base.hpp"
+#include "base_store.hpp"
+#include "world.hpp"
+#include "protocol.hpp"
+#include "save.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// authoritative server, every player's base is simulated here and clients
+//   only send commands and draw the states they're sent back
+// sockets are polled on one thread between ticks, the bases are ticked
+//   as jobs across every worker, posix only
+class Server
+{
+public:
+	Server(int const _tick_ms);
+	~Server();
+
+	Server(Server const&) = delete;
+	void operator=(Server const&) = delete;
+
+public:
+	// "tcp:<port>" on 127.0.0.1 or "unix:<path>"
+	bool listen(std::string const& address);
+
+	// where attacks find opponents, every player's base is put there when
+	//   they first connect and when they leave, without one ATTACK is
+	//   UNSUPPORTED
+	bool open_store(std::string const& dir);
+
+	// until stop(), which is safe from a signal handler or another thread
+	void run();
+	void stop();
+
+	// prints and resets the counters every stats_ms, 0 never
+	void set_stats_interval(int const _stats_ms);
+
+	int player_count() const;
+	int client_count() const;
+
+	// since the server started, only safe to read once run() has returned
+	struct Totals
+	{
+		uint64_t ticks;
+		uint64_t tick_ns, tick_max_ns, sim_ns;
+		uint64_t commands;
+		uint64_t bytes_in, bytes_out;
+	};
+
+	Totals const& get_totals() const;
+
+private:
+	struct Player
+	{
+		uint64_t id;
+		Base* base; // owned by the world
+		bool connected;
+	};
+
+	struct Client
+	{
+		int fd;
+		std::vector<char> in, out;
+		Player* player;
+
+		// STATE deltas are against the last state the client acked, and
+		//   the next isn't sent until the one in flight is acked
+		save::Snapshot acked, sent;
+		uint32_t acked_tick, sent_tick;
+		bool in_flight;
+	};
+
+	void accept_clients();
+	// false once the client should be dropped
+	bool read_client(Client& c);
+	bool handle_message(Client& c, char const* data, std::size_t size);
+	net::Status handle_command(Player& p, net::CommandMsg const& m);
+	bool flush_client(Client& c);
+	void drop_client(std::size_t i);
+
+	void tick();
+	void print_stats();
+
+private:
+	int tick_ms;
+	int listen_fd;
+	std::string unix_path;
+	std::atomic<bool> stopping;
+
+	World world;
+	std::unique_ptr<BaseStore> store;
+	Rng match_rng;
+	std::unordered_map<uint64_t, std::unique_ptr<Player>> players;
+	std::vector<std::unique_ptr<Client>> clients;
+
+	uint32_t ticks;
+
+	// since the last print
+	int stats_ms;
+	uint64_t stats_start_ns;
+	uint64_t tick_ns, tick_max_ns, sim_ns;
+	int stats_ticks, commands;
+	uint64_t bytes_in, bytes_out;
+
+	Totals totals;
+};
+
+// resident memory of the process in bytes, 0 where /proc isn't there
+std::size_t resident_bytes();
@@ -0,0 +1,209 @@
+#include "alloc_tracker.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace
+{
+
+std::atomic<std::size_t> alloc_count{ 0 };
+std::atomic<std::size_t> alloc_bytes{ 0 };
+std::atomic<std::size_t> free_count{ 0 };
+
+// constant initialized, so operator new can touch it on any thread
+thread_local std::size_t thread_alloc_count = 0;
+
+char const* const NO_ZONE = "(no zone)";
+
+// open addressed on the zone name's address, slots are claimed once and
+//   never freed so operator new can count without taking a lock or allocating
+struct ZoneCounter
+{
+	std::atomic<char const*> name{ nullptr };
+	std::atomic<std::size_t> count{ 0 }, bytes{ 0 };
+	std::atomic<std::size_t> frame_count{ 0 }, frame_bytes{ 0 };
+};
+
+std::array<ZoneCounter, 256> zone_counters;
+
+ZoneCounter& zone_counter(char const* name)
+{
+	std::size_t const start = ((uintptr_t)name >> 3) % zone_counters.size();
+
+	for (std::size_t i = 0; i < zone_counters.size(); ++i)
+	{
+		auto& counter = zone_counters[(start + i) % zone_counters.size()];
+
+		char const* slot = counter.name.load(std::memory_order_acquire);
+		if (slot == nullptr && counter.name.compare_exchange_strong(slot, name, std::memory_order_acq_rel))
+			return counter;
+		if (slot == name)
+			return counter;
+	}
+
+	// full, lump the rest in with unattributed allocations
+	return name == NO_ZONE ? zone_counters[0] : zone_counter(NO_ZONE);
+}
+
+std::size_t budget = alloc::NO_BUDGET;
+alloc::BudgetAction budget_action = alloc::BudgetAction::LOG;
+int warmup = 0;
+
+std::size_t frame_start = 0;
+
+[[maybe_unused]] void track(std::size_t size)
+{
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+	thread_alloc_count++;
+
+	char const* zone = prof::current_zone();
+	auto& counter = zone_counter(zone ? zone : NO_ZONE);
+	counter.count.fetch_add(1, std::memory_order_relaxed);
+	counter.bytes.fetch_add(size, std::memory_order_relaxed);
+	counter.frame_count.fetch_add(1, std::memory_order_relaxed);
+	counter.frame_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+}
+
+namespace alloc
+{
+
+std::size_t count()
+{
+	return alloc_count.load(std::memory_order_relaxed);
+}
+
+std::size_t thread_count()
+{
+	return thread_alloc_count;
+}
+
+std::size_t bytes()
+{
+	return alloc_bytes.load(std::memory_order_relaxed);
+}
+
+std::size_t frees()
+{
+	return free_count.load(std::memory_order_relaxed);
+}
+
+std::vector<ZoneAllocs> zones()
+{
+	std::vector<ZoneAllocs> result;
+	for (auto const& counter : zone_counters)
+	{
+		char const* name = counter.name.load(std::memory_order_acquire);
+		if (name == nullptr)
+			continue;
+
+		// the same literal can live at different addresses in different files
+		auto it = std::find_if(result.begin(), result.end(), [&](ZoneAllocs const& z) {
+			return std::strcmp(z.name, name) == 0;
+		});
+		if (it == result.end())
+			it = result.insert(result.end(), ZoneAllocs{ name, 0, 0 });
+
+		it->count += counter.count.load(std::memory_order_relaxed);
+		it->bytes += counter.bytes.load(std::memory_order_relaxed);
+	}
+
+	std::sort(result.begin(), result.end(), [](ZoneAllocs const& a, ZoneAllocs const& b) {
+		return a.count > b.count;
+	});
+
+	return result;
+}
+
+void set_frame_budget(std::size_t max_allocs, BudgetAction const action, int warmup_frames)
+{
+	budget = max_allocs;
+	budget_action = action;
+	warmup = warmup_frames;
+}
+
+std::size_t end_frame()
+{
+	std::size_t const allocs = count() - frame_start;
+
+	if (warmup > 0)
+		warmup--;
+	else if (budget != NO_BUDGET && allocs > budget)
+	{
+		std::vector<ZoneAllocs> worst;
+		for (auto const& counter : zone_counters)
+		{
+			char const* name = counter.name.load(std::memory_order_acquire);
+			std::size_t const n = counter.frame_count.load(std::memory_order_relaxed);
+			if (name != nullptr && n > 0)
+				worst.push_back(ZoneAllocs{ name, n, counter.frame_bytes.load(std::memory_order_relaxed) });
+		}
+
+		std::sort(worst.begin(), worst.end(), [](ZoneAllocs const& a, ZoneAllocs const& b) {
+			return a.count > b.count;
+		});
+
+		std::cout << "[error] - frame made " << allocs << " allocations, budget is " << budget << '\n';
+		for (std::size_t i = 0; i < std::min<std::size_t>(worst.size(), 5); ++i)
+			std::cout << "    " << worst[i].name << ": " << worst[i].count << " (" << worst[i].bytes << " bytes)\n";
+
+		if (budget_action == BudgetAction::ASSERT)
+		{
+			std::cout.flush();
+			std::abort();
+		}
+	}
+
+	for (auto& counter : zone_counters)
+	{
+		counter.frame_count.store(0, std::memory_order_relaxed);
+		counter.frame_bytes.store(0, std::memory_order_relaxed);
+	}
+
+	// after logging, so the report itself is not charged to the next frame
+	frame_start = count();
+
+	return allocs;
+}
+
+}
+
+#ifdef KINGDOM_TRACK_ALLOCS
+
+void* operator new(std::size_t size)
+{
+	track(size);
+
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	if (ptr)
+		free_count.fetch_add(1, std::memory_order_relaxed);
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete(ptr); }
+
+#endif
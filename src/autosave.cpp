@@ -0,0 +1,84 @@
+#include "autosave.hpp"
+#include "base.hpp"
+#include "save.hpp"
+#include "profiler.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+Autosave::Autosave(std::string const& _path, int const _interval_ms)
+	: path(_path), interval_ms(_interval_ms), last_ms(prof::now_ns() / 1000000)
+	, stopping(false), busy(false), saves(0)
+	, worker(&Autosave::worker_loop, this)
+{
+
+}
+
+Autosave::~Autosave()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	cv.notify_one();
+	worker.join();
+}
+
+void Autosave::update(Base const& base)
+{
+	uint64_t const now_ms = prof::now_ns() / 1000000;
+	if (now_ms - last_ms < (uint64_t)interval_ms || busy.load(std::memory_order_acquire))
+		return;
+
+	PROFILE_SCOPE("Autosave::update");
+
+	last_ms = now_ms;
+	busy.store(true, std::memory_order_release);
+
+	auto snap = std::make_unique<save::Snapshot>(base.snapshot());
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = std::move(snap);
+	}
+	cv.notify_one();
+}
+
+bool Autosave::is_busy() const
+{
+	return busy.load(std::memory_order_acquire);
+}
+
+int Autosave::get_saves() const
+{
+	return saves.load(std::memory_order_relaxed);
+}
+
+void Autosave::worker_loop()
+{
+	while (true)
+	{
+		std::unique_ptr<save::Snapshot> snap;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&] { return stopping || job; });
+
+			// a save still queued when quitting is written before stopping
+			if (!job)
+				return;
+			snap = std::move(job);
+		}
+
+		{
+			PROFILE_SCOPE("Autosave::write");
+
+			auto const bytes = save::compress(save::encode(*snap));
+			if (save::write_file(path, bytes.data(), bytes.size()))
+				saves.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// dropping the snapshot here lets the base write its layers in place again
+		snap.reset();
+		busy.store(false, std::memory_order_release);
+	}
+}
@@ -3,11 +3,21 @@
 #include "person.hpp"
 #include "tile.hpp"
 #include "building.hpp"
+#include "building_type.hpp"
 #include "sdl2.hpp"
-
+#include "depth_sort.hpp"
+#include "alloc_tracker.hpp"
+#include "particles.hpp"
+#include "profiler.hpp"
+#include "frame_arena.hpp"
+#include "rng.hpp"
+#include "jobs.hpp"
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <ctime>
 #include <iostream>
-#include <iomanip>
 #include <random>
 #include <cmath>
 #include <string>
@@ -22,177 +32,408 @@ Base& Base::get()
 }
 
 Base::Base()
-	: gold(250), wheat(250), wood(500), stone(0), gems(10)
+	: gold(250), wheat(250), wood(500), stone(0), iron(0), gems(10)
 	, level(1), exp(0), troph(0)
-	, edit_mode(false), shop_state(ShopState::HIDDEN)
+	, edit_mode(false), headless(false)
+	, shop_state(ShopState::HIDDEN), shop_y(Screen::get().SCREEN_HEIGHT)
 	, TILES_X(58), TILES_Y(23)
 	, tiles(TILES_Y, std::vector<Tile>(TILES_X, Tile{ TileState::GRASS }))
+	, tile_layer(std::make_shared<std::vector<uint8_t>>(TILES_X * TILES_Y, (uint8_t)TileState::GRASS))
+	, building_layer(std::make_shared<std::vector<save::BuildingRecord>>())
 	, place(nullptr)
+	, depth_sort(Screen::get().SCREEN_WIDTH, Screen::get().SCREEN_HEIGHT)
 	, text_build("BUILD", Screen::get().SCREEN_WIDTH - 20, Screen::get().SCREEN_HEIGHT - 65, sdl2::TextAlign::CENTER_RIGHT)
 {
 	farmers.push_back(Person{ { TILES_X / 2, TILES_Y / 2 }, { TILES_X / 2.f * 20 + 5, TILES_Y / 2.f * 20 + 60 } });
 	farmers.push_back(Person{ { TILES_X / 2 - 5, TILES_Y / 2 + 7 }, { (TILES_X / 2.f - 5 ) * 20 + 5, (TILES_Y / 2.f + 7) * 20 + 60 } });
 }
 
-void Base::set_building_dim()
+void Base::seed(uint64_t const seed)
+{
+	rng.seed(seed);
+}
+
+void Base::reset(int const tiles_x, int const tiles_y)
+{
+	TILES_X = tiles_x;
+	TILES_Y = tiles_y;
+	tiles.assign(TILES_Y, std::vector<Tile>(TILES_X, Tile{ TileState::GRASS }));
+	tile_layer = std::make_shared<std::vector<uint8_t>>(TILES_X * TILES_Y, (uint8_t)TileState::GRASS);
+
+	farmers.clear();
+	base_buildings.clear();
+	building_layer = std::make_shared<std::vector<save::BuildingRecord>>();
+	place = nullptr;
+	place_state = PlaceState::STATIONERY;
+}
+
+bool Base::add_building(int const type, int x, int y)
 {
-	auto [x1, y1] = Screen::get().get_img_dim("farmhouse.png");
-	shop_buildings.push_back(std::make_unique<ProdBuilding>(
-		"farmhouse.png",
-		sdl2::Dimension{200, Screen::get().SCREEN_HEIGHT - 150,
-			(int)(x1 * 0.25), (int)(y1 * 0.25) },
-		2, 100, 0, 0, 0,
-		ProdType::WHEAT, 3, 6, 100
-	));
-
-	auto [x2, y2] = Screen::get().get_img_dim("lumbermill.png");
-	shop_buildings.push_back(std::make_unique<ProdBuilding>(
-		"lumbermill.png",
-		sdl2::Dimension{ 600, Screen::get().SCREEN_HEIGHT - 150,
-			(int)(x2 * 0.25), (int)(y2 * 0.25) },
-		0, 100, 0, 0, 0,
-		ProdType::WOOD, 3, 10, 100
-	));
-
-	auto [x3, y3] = Screen::get().get_img_dim("road.png");
-	shop_buildings.push_back(std::make_unique<Building>(
-		"road.png",
-		sdl2::Dimension{ 1000, Screen::get().SCREEN_HEIGHT - 150,
-			(int)(x3 * 0.15), (int)(y3 * 0.25) },
-		0, 10, 0, 0, 0
-	));
+	auto building = Building::create(type, x, y);
+	building->snap_to(x, y);
+
+	return insert_building(std::move(building));
 }
 
-void Base::display_resources()
+bool Base::insert_building(std::shared_ptr<Building> building)
 {
-	Screen::get().fill(sdl2::clr_black);
-	Screen::get().stroke(sdl2::clr_clear);
-	Screen::get().rect(0, 0, Screen::get().SCREEN_WIDTH, 50);
-
-	Screen::get().fill(sdl2::clr_yellow);
-	Screen::get().rect(0, 50, Screen::get().SCREEN_WIDTH, 5);
-
-	std::string str[] = {
-		"Gold: " + std::to_string(Base::get().gold),
-		"Wheat: " + std::to_string(Base::get().wheat),
-		"Wood: " + std::to_string(Base::get().wood),
-		"Gems: " + std::to_string(Base::get().gems),
-	};
-
-	std::string imgs[] = { "gold.png", "wheat.png", "wood.png", "gems.png" };
-
-	int pos[] = {
-		0,
-		(Screen::get().SCREEN_WIDTH / 4),
-		(Screen::get().SCREEN_WIDTH / 4 * 2),
-		(Screen::get().SCREEN_WIDTH / 4 * 3)
-	};
-
-	sdl2::font_ptr ttf_font(TTF_OpenFont(sdl2::str_brygada.c_str(), 24));
-	int text_w, text_h;
-	TTF_SizeText(ttf_font.get(), str[3].c_str(), &text_w, &text_h);
-	int margin = (Screen::get().SCREEN_WIDTH - (Screen::get().SCREEN_WIDTH / 4 * 3 + text_w)) / 2;
-
-	Screen::get().fill(sdl2::clr_yellow);
-	for (int i = 0; i < sizeof(str) / sizeof(str[0]); ++i)
+	if (can_place_building(*building) != 0)
+		return false;
+
+	occupy(*building);
+	writable_building_layer().push_back(record_of(*building));
+	base_buildings.push_back(std::move(building));
+	return true;
+}
+
+bool Base::perform(Action const& action)
+{
+	if (!apply(action))
+		return false;
+
+	if (on_action)
+		on_action(action);
+	return true;
+}
+
+bool Base::apply(Action const& action)
+{
+	switch (action.type)
+	{
+	case ActionType::PLACE:
+	{
+		if (action.a < 0 || action.a >= BuildingCatalog::get().size() || action.b < 0 || action.c < 0)
+			return false;
+
+		// the client snaps before sending, positions from the network or a
+		//   journal are snapped the same way so every replay agrees with it
+		auto building = Building::create(action.a, action.b, action.c);
+		building->snap_to(action.b, action.c);
+		if (!building->can_buy(gold, wood, stone, iron) || !insert_building(std::move(building)))
+			return false;
+
+		auto const& type = BuildingCatalog::get()[action.a];
+		gold -= type.cost_gold;
+		wood -= type.cost_wood;
+		stone -= type.cost_stone;
+		iron -= type.cost_iron;
+		return true;
+	}
+	case ActionType::COLLECT:
+	{
+		if (action.a < 0 || action.a >= (int)base_buildings.size())
+			return false;
+
+		auto& building = *base_buildings[action.a];
+		building.collect_item(gold, wheat, wood, stone, iron);
+		writable_building_layer()[action.a].amount = building.get_amount();
+
+		auto const& type = building.get_type();
+		if (!headless && type.prod)
+		{
+			auto const d = building.dim();
+			Particles::get().spawn(rng[RngStream::PARTICLES], type.prod_type, d.x, d.y - (d.h / 2), 10);
+		}
+		return true;
+	}
+	case ActionType::MOVE:
+	{
+		if (action.a < 0 || action.a >= (int)base_buildings.size() || action.b < 0 || action.c < 0)
+			return false;
+
+		// its own tiles don't block it, a failed move puts it back
+		auto& building = *base_buildings[action.a];
+		auto const prev_x = building.x, prev_y = building.y;
+		vacate(building);
+		building.snap_to(action.b, action.c);
+
+		bool const moved = can_place_building(building) == 0;
+		if (!moved)
+		{
+			building.x = prev_x;
+			building.y = prev_y;
+		}
+
+		occupy(building);
+		auto& record = writable_building_layer()[action.a];
+		record.x = building.x;
+		record.y = building.y;
+		return moved;
+	}
+	case ActionType::PRODUCE:
 	{
-		Screen::get().image_align(sdl2::ImageAlign::CENTER_RIGHT);
-		Screen::get().image(imgs[i],(Screen::get().SCREEN_WIDTH / 4 * i) + margin - 10, 4, 40, 40);
+		Jobs::get().parallel_for(base_buildings.size(), PRODUCE_GRAIN, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i)
+				base_buildings[i]->add_resources();
+		});
+
+		// full buildings don't change, if none did the layer stays shared
+		//   with the snapshots holding it and there's no state to send
+		for (std::size_t i = 0; i < base_buildings.size(); ++i)
+		{
+			if ((*building_layer)[i].amount == base_buildings[i]->get_amount())
+				continue;
 
-		Screen::get().text_size(10);
-		Screen::get().text_font(sdl2::str_brygada);
-		Screen::get().text_align(sdl2::ImageAlign::CENTER_LEFT);
-		Screen::get().text(str[i], 24, (Screen::get().SCREEN_WIDTH / 4 * i) + margin);
+			auto& records = writable_building_layer();
+			for (; i < base_buildings.size(); ++i)
+				records[i].amount = base_buildings[i]->get_amount();
+		}
+		return true;
 	}
+	}
+
+	return false;
 }
 
-void Base::display_scene(bool second)
+bool Base::add_farmer(int const tile_x, int const tile_y)
 {
-	display_farmers();
+	if (tile_y < 0 || tile_y >= TILES_Y || tile_x < 0 || tile_x >= TILES_X
+		|| tiles[tile_y][tile_x].state == TileState::OCCUPIED)
+		return false;
 
-	if (place != nullptr)
-		display_grid();
+	farmers.push_back(Person{ { tile_x, tile_y }, { tile_x * 20.f + 5, tile_y * 20.f + 60 } });
+	return true;
+}
 
-	display_base_buildings();
-	manage_resources(second);
+void Base::tick(bool second)
+{
+	update_farmers();
 
-	if (place != nullptr)
-		place->display_placement_options();
+	if (second)
+		perform(Action{ ActionType::PRODUCE, 0, 0, 0 });
+}
+
+save::Snapshot Base::snapshot() const
+{
+	PROFILE_SCOPE("Base::snapshot");
+
+	save::Snapshot snap{};
+	snap.header.saved_at = (uint64_t)std::time(nullptr);
+	snap.header.gold = gold;
+	snap.header.wheat = wheat;
+	snap.header.wood = wood;
+	snap.header.stone = stone;
+	snap.header.iron = iron;
+	snap.header.gems = gems;
+	snap.header.level = level;
+	snap.header.exp = exp;
+	snap.header.troph = troph;
+	snap.header.tiles_x = TILES_X;
+	snap.header.tiles_y = TILES_Y;
+
+	snap.tiles = tile_layer;
+	snap.buildings = building_layer;
+
+	return snap;
+}
+
+// copy on write, a snapshot still holding the layer keeps the old copy
+// use_count() is a relaxed load, the fence pairs it with the release in
+//   whichever thread dropped the last snapshot so its reads of the layer
+//   happen before the writes in place
+std::vector<uint8_t>& Base::writable_tile_layer()
+{
+	if (tile_layer.use_count() > 1)
+		tile_layer = std::make_shared<std::vector<uint8_t>>(*tile_layer);
+	else
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+	return *tile_layer;
+}
 
-	not_enough_resources();
+std::vector<save::BuildingRecord>& Base::writable_building_layer()
+{
+	if (building_layer.use_count() > 1)
+		building_layer = std::make_shared<std::vector<save::BuildingRecord>>(*building_layer);
+	else
+		std::atomic_thread_fence(std::memory_order_acquire);
 
-	
-	Screen::get().stroke(sdl2::clr_black);
-	Screen::get().fill(sdl2::clr_white);
-	Screen::get().trig_align(sdl2::TrigAlign::CENTER);
-	Screen::get().trig(200, 200, 250, 150, 250, 250, sdl2::TrigQuad::MIDDLE);
+	return *building_layer;
 }
 
-void Base::display_shop()
+save::BuildingRecord Base::record_of(Building const& b) const
 {
-	static int shop_y = Screen::get().SCREEN_HEIGHT;
-	const int shop_h = Screen::get().SCREEN_HEIGHT - 300;
-	const int shop_spd = 15;
+	return save::BuildingRecord{ (uint16_t)b.type, (uint16_t)b.level, b.x, b.y, b.get_amount() };
+}
 
-	switch (shop_state)
+void Base::restore(save::View const& v)
+{
+	auto const& h = *v.header;
+
+	reset(h.tiles_x, h.tiles_y);
+
+	gold = h.gold;
+	wheat = h.wheat;
+	wood = h.wood;
+	stone = h.stone;
+	iron = h.iron;
+	gems = h.gems;
+	level = h.level;
+	exp = h.exp;
+	troph = h.troph;
+
+	for (int i = 0; i < TILES_Y; ++i)
 	{
-	case ShopState::HIDDEN: {
-		if (place == nullptr)
+		for (int j = 0; j < TILES_X; ++j)
+			tiles[i][j].state = (TileState)v.tiles[i * TILES_X + j];
+	}
+	tile_layer->assign(v.tiles, v.tiles + TILES_X * TILES_Y);
+
+	base_buildings.reserve(h.building_count);
+	for (uint32_t i = 0; i < h.building_count; ++i)
+	{
+		auto const& rec = v.buildings[i];
+		if (rec.type >= BuildingCatalog::get().size())
 		{
-			Screen::get().fill(sdl2::clr_white);
-			Screen::get().text_font(sdl2::str_brygada);
-			Screen::get().text_size(45);
-			Screen::get().text_align(text_build.align);
-			Screen::get().text("BUILD", text_build.dim.x, text_build.dim.y);
+			std::cout << "[error] - save has unknown building type " << rec.type << '\n';
+			continue;
 		}
 
-		shop_y = Screen::get().SCREEN_HEIGHT;
-
-		break;
+		auto building = Building::create(rec.type, rec.x, rec.y);
+		building->level = rec.level;
+		building->set_amount(rec.amount);
+		building_layer->push_back(record_of(*building));
+		base_buildings.push_back(std::move(building));
 	}
-	case ShopState::APPEARING: {
-		Screen::get().fill(sdl2::clr_black);
-		Screen::get().stroke(sdl2::clr_clear);
-		Screen::get().rect(0, shop_y, Screen::get().SCREEN_WIDTH, Screen::get().SCREEN_HEIGHT - shop_h);
 
+	// farmers aren't saved, they walk off from the middle like a new base
+	add_farmer(TILES_X / 2, TILES_Y / 2);
+}
+
+int Base::building_count() const
+{
+	return base_buildings.size();
+}
+
+int Base::farmer_count() const
+{
+	return farmers.size();
+}
+
+void Base::update_ui()
+{
+	const int shop_h = Screen::get().SCREEN_HEIGHT - 300;
+	const int shop_spd = 15;
+
+	switch (shop_state)
+	{
+	case ShopState::HIDDEN:
+		shop_y = Screen::get().SCREEN_HEIGHT;
+		break;
+	case ShopState::APPEARING:
 		shop_y -= shop_spd;
 		if (shop_y <= shop_h)
 		{
 			shop_state = ShopState::VISIBLE;
 			shop_y = shop_h;
 		}
-
+		break;
+	case ShopState::VISIBLE:
+		break;
+	case ShopState::DISAPPEARING:
+		shop_y += shop_spd;
+		if (shop_y >= Screen::get().SCREEN_HEIGHT)
+		{
+			shop_state = ShopState::HIDDEN;
+			shop_y = Screen::get().SCREEN_HEIGHT;
+		}
 		break;
 	}
-	case ShopState::VISIBLE: {
-		Screen::get().fill(sdl2::clr_black);
-		Screen::get().stroke(sdl2::clr_clear);
-		Screen::get().rect(0, shop_h, Screen::get().SCREEN_WIDTH, Screen::get().SCREEN_HEIGHT - shop_h);
 
-		Screen::get().fill(sdl2::clr_white);
-		Screen::get().text("CLOSE", sdl2::str_brygada, 35,
-			Screen::get().SCREEN_WIDTH - 15, shop_h - 40, sdl2::Align::RIGHT);
+	for (auto it = resources_msg.begin(); it != resources_msg.end();)
+	{
+		auto& [end, txt] = *it;
 
-		for (auto const& building : shop_buildings)
-			building->display_building(false);
+		txt.dim.y--;
 
-		break;
+		if (txt.dim.y <= end + 5)
+			it = resources_msg.erase(it);
+		else
+			++it;
 	}
-	case ShopState::DISAPPEARING: {
-		Screen::get().fill(sdl2::clr_black);
-		Screen::get().stroke(sdl2::clr_clear);
-		Screen::get().rect(0, shop_y, Screen::get().SCREEN_WIDTH, Screen::get().SCREEN_HEIGHT - shop_h);
 
-		shop_y += shop_spd;
-		if (shop_y >= Screen::get().SCREEN_HEIGHT)
+	if (!headless)
+		Particles::get().update();
+}
+
+void Base::capture(RenderSnapshot& s)
+{
+	PROFILE_SCOPE("Base::capture");
+
+	s.gold = gold;
+	s.wheat = wheat;
+	s.wood = wood;
+	s.stone = stone;
+	s.iron = iron;
+	s.gems = gems;
+
+	depth_sort.clear();
+
+	for (int i = 0; i < (int)base_buildings.size(); ++i)
+	{
+		auto const dim = base_buildings[i]->dim();
+		depth_sort.push(dim.x, dim.y + (dim.h / 2), DrawKind::BUILDING, i);
+	}
+
+	s.placing = place != nullptr;
+	if (place != nullptr)
+	{
+		auto const dim = place->dim();
+		depth_sort.push(dim.x, dim.y + (dim.h / 2), DrawKind::PREVIEW, -1);
+	}
+
+	// farmer sprites are 60 high and centered on their position
+	for (int i = 0; i < (int)farmers.size(); ++i)
+	{
+		auto const& pos = farmers[i].actual_pos;
+		depth_sort.push((int)pos.x, (int)pos.y + 30, DrawKind::FARMER, i);
+	}
+
+	s.scene.clear();
+	for (auto const& drawable : depth_sort.sort())
+	{
+		RenderSnapshot::Sprite sprite{ drawable.kind, false, -1, drawable.x, drawable.y, drawable.y };
+		switch (drawable.kind)
 		{
-			shop_state = ShopState::HIDDEN;
-			shop_y = Screen::get().SCREEN_HEIGHT;
+		case DrawKind::BUILDING: {
+			auto const& building = *base_buildings[drawable.index];
+			sprite = { drawable.kind, place != nullptr, (int16_t)building.type, building.x, building.y, drawable.y };
+			break;
+		}
+		case DrawKind::PREVIEW: {
+			sprite = { drawable.kind, can_place_building(*place) == 0, (int16_t)place->type, place->x, place->y, drawable.y };
+			s.preview = sprite;
+			break;
+		}
+		case DrawKind::FARMER: {
+			auto const& pos = farmers[drawable.index].actual_pos;
+			sprite.x = (int)pos.x;
+			sprite.y = (int)pos.y;
+			break;
+		}
 		}
 
-		break;
+		s.scene.push_back(sprite);
 	}
+
+	s.bubbles.clear();
+	for (auto const& building : base_buildings)
+	{
+		if (building->is_item_cap())
+			s.bubbles.push_back({ (int16_t)building->type, building->x, building->y });
 	}
+
+	if (headless)
+		s.particles.clear();
+	else
+		Particles::get().capture(s.particles);
+
+	s.messages.clear();
+	for (auto const& [end, txt] : resources_msg)
+		s.messages.push_back({ txt.dim.x, txt.dim.y, 1 - (end - txt.dim.y) / 100.f });
+
+	s.shop_state = (int)shop_state;
+	s.shop_y = shop_y;
 }
 
 void Base::handle_mouse_pressed(int x, int y)
@@ -205,8 +446,8 @@ void Base::handle_mouse_pressed(int x, int y)
 		}
 		else if (place != nullptr)
 		{
-			auto const building = *place.get();
-			auto const& [img, dim, height_d, cost_g, cost_w, cost_s, cost_i, id] = building;
+			auto const& building = *place;
+			auto const dim = building.dim();
 			int const base = dim.y - (dim.h / 2) - 30;
 			
 			if (std::sqrt(std::pow(x - (dim.x - 40), 2) + std::pow(y - base, 2)) <= 20 &&
@@ -218,33 +459,17 @@ void Base::handle_mouse_pressed(int x, int y)
 					{
 						resources_msg.push_back({
 							dim.y - 130,
-							sdl2::Text("Not enough resources", dim.x, dim.y - 30, sdl2::Align::CENTER)
+							sdl2::Text("Not enough resources", dim.x, dim.y - 30, sdl2::TextAlign::CENTER)
 						});
 					}
 
 					return;
 				}
 
-				int x1 = ((dim.x - (dim.w / 2)) - 5) / 20;
-				int x2 = ((dim.x + (dim.w / 2)) - 5) / 20;
-				int y1 = ((dim.y - (dim.h / 2) + (height_d * 20)) - 60) / 20;
-				int y2 = ((dim.y + (dim.h / 2)) - 60) / 20;
-
-				for (int i = y1; i <= y2; ++i)
-				{
-					for (int j = x1; j <= x2; ++j)
-						tiles[i][j].state = img == "road.png" ? TileState::PATH : TileState::OCCUPIED;
-				}
-
-				gold -= cost_g;
-				wood -= cost_w;
-				stone -= cost_s;
-				place = nullptr;
-				place_state = PlaceState::STATIONERY;
+				commit_place();
 			}
 			else if (std::sqrt(std::pow(x - (dim.x + 40), 2) + std::pow(y - base, 2)) <= 20)
 			{
-				base_buildings.erase(place);
 				place = nullptr;
 
 				shop_state = ShopState::APPEARING;
@@ -255,7 +480,7 @@ void Base::handle_mouse_pressed(int x, int y)
 			for (auto const& building : base_buildings)
 			{
 				if (building->is_item_pressed(x, y))
-					building->collect_item(gold, wheat, wood, stone, iron);
+					perform(Action{ ActionType::COLLECT, (int32_t)(&building - base_buildings.data()), 0, 0 });
 			}
 		}
 	}
@@ -271,19 +496,16 @@ void Base::handle_mouse_pressed(int x, int y)
 
 void Base::handle_mouse_dragged(int x, int y)
 {
-	Screen::get().fill(sdl2::clr_green);
-	Screen::get().stroke(sdl2::clr_clear);
-	Screen::get().rhom(x, y, 100, 50);
-
 	if (shop_state == ShopState::VISIBLE)
 	{
 		assert(place == nullptr);
 
-		for (auto const& building : shop_buildings)
+		for (int i = 0; i < BuildingCatalog::get().size(); ++i)
 		{
-			if (building->is_pressed(x, y))
+			auto const [bx, by, bw, bh] = shop_dim(i);
+			if (x >= bx - (bw / 2) && x <= bx + (bw / 2) && y >= by - (bh / 2) && y <= by + (bh / 2))
 			{
-				update_base_buildings(building.get(), true);
+				place = Building::create(i, bx, by);
 
 				place_state = PlaceState::FOLLOW_MOUSE;
 				shop_state = ShopState::HIDDEN;
@@ -299,13 +521,27 @@ void Base::handle_mouse_dragged(int x, int y)
 		if (place->is_pressed(x, y))
 		{
 			place_state = PlaceState::FOLLOW_MOUSE;
-			place_offset = { x - place->dim.x, y - place->dim.y };
+			place_offset = { x - place->x, y - place->y };
 		}
 
 		if (shop_state == ShopState::HIDDEN && place_state == PlaceState::FOLLOW_MOUSE)
 		{
-			if (can_place_building(*place) != 2)
-				update_base_buildings(place.get(), false, x, y);
+#ifdef KINGDOM_TRACK_ALLOCS
+			auto const allocs = alloc::thread_count();
+#endif
+
+			// the preview is moved in place, only committing it allocates
+			auto const prev_x = place->x, prev_y = place->y;
+			place->snap_to(x, y);
+			if (can_place_building(*place) == 2)
+			{
+				place->x = prev_x;
+				place->y = prev_y;
+			}
+
+#ifdef KINGDOM_TRACK_ALLOCS
+			assert(alloc::thread_count() == allocs);
+#endif
 		}
 	}
 }
@@ -317,10 +553,8 @@ void Base::handle_mouse_released(int x, int y)
 
 int Base::can_place_building(Building const& b) const
 {
-	int x1 = ((b.dim.x - (b.dim.w / 2)) - 5) / 20;
-	int x2 = ((b.dim.x + (b.dim.w / 2)) - 5) / 20;
-	int y1 = ((b.dim.y - (b.dim.h / 2) + (b.height_d * 20)) - 60) / 20;
-	int y2 = ((b.dim.y + (b.dim.h / 2)) - 60) / 20;
+	int x1, y1, x2, y2;
+	footprint(b, x1, y1, x2, y2);
 
 	bool can_place = true;
 	bool out = false;
@@ -328,7 +562,7 @@ int Base::can_place_building(Building const& b) const
 	{
 		for (int j = y1; j <= y2; ++j)
 		{
-			if (i < 0 || i >= tiles[j].size() || j < 0 || j >= tiles.size())
+			if (j < 0 || j >= (int)tiles.size() || i < 0 || i >= (int)tiles[j].size())
 			{
 				out = true;
 				break;
@@ -343,134 +577,136 @@ int Base::can_place_building(Building const& b) const
 			   : !can_place;
 }
 
-void Base::update_base_buildings(Building* building, bool shrink, int x, int y)
+void Base::commit_place()
 {
-	if (place != nullptr)
-		base_buildings.erase(place);
+	perform(Action{ ActionType::PLACE, place->type, place->x, place->y });
 
-	place = building->create_building(shrink, x, y);
-	base_buildings.insert(place);
+	place = nullptr;
+	place_state = PlaceState::STATIONERY;
 }
 
-void Base::display_farmers()
+void Base::occupy(Building const& b)
 {
-	float const spd = 0.5f;
-	static int step_size = 20 / spd;
-
-	for (auto& farmer : farmers)
-	{
-		Screen::get().image(
-			"farmer.png",
-			(int)farmer.actual_pos.x, (int)farmer.actual_pos.y, 100, 60,
-			sdl2::Align::CENTER);
-
-		if (farmer.path.empty())
-			farmer.generate_path(tiles);
-
-		auto const& dest = farmer.path[0];
-		if (step_size == 0)
-		{
-			farmer.path_pos = farmer.path[0];
-			farmer.path.pop_front();
-
-			step_size = 20 / spd;
-		}
-		else
-		{
-			if (farmer.path_pos.x < dest.x)
-				farmer.actual_pos.x += spd;
-			else if (farmer.path_pos.x > dest.x)
-				farmer.actual_pos.x -= spd;
-			else if (farmer.path_pos.y < dest.y)
-				farmer.actual_pos.y += spd;
-			else if (farmer.path_pos.y > dest.y)
-				farmer.actual_pos.y -= spd;
-
-			step_size--;
-		}
-	}
+	int x1, y1, x2, y2;
+	footprint(b, x1, y1, x2, y2);
+	raise_tiles(b, x1, y1, x2, y2);
 }
 
-void Base::display_base_buildings()
+void Base::vacate(Building const& b)
 {
-	for (auto& building : base_buildings)
+	int x1, y1, x2, y2;
+	footprint(b, x1, y1, x2, y2);
+
+	auto& layer = writable_tile_layer();
+	for (int i = y1; i <= y2; ++i)
 	{
-		if (building == place)
+		for (int j = x1; j <= x2; ++j)
 		{
-			int can_place = can_place_building(*building);
-			building->display_backdrop(!can_place ? sdl2::clr_green : sdl2::clr_red);
+			tiles[i][j].state = TileState::GRASS;
+			layer[i * TILES_X + j] = (uint8_t)TileState::GRASS;
 		}
-
-		building->display_building(place != nullptr && building != place);
-		building->display_item_collect();
 	}
-}
 
-void Base::manage_resources(bool second)
-{
-	for (auto& building : base_buildings)
+	// a house can stand on a road, whatever else is on those tiles puts
+	//   its state back
+	for (auto const& other : base_buildings)
 	{
-		if (place == building)
-			continue;
-
-		if (second)
-			building->add_resources();
-
-		if (building->is_item_cap())
-			building->display_item();
+		if (other.get() != &b)
+			raise_tiles(*other, x1, y1, x2, y2);
 	}
 }
 
-void Base::not_enough_resources()
+void Base::footprint(Building const& b, int& x1, int& y1, int& x2, int& y2) const
 {
-	for (auto it = resources_msg.begin(); it != resources_msg.end();)
-	{
-		auto const& [end, txt] = *it;
+	auto const dim = b.dim();
+	auto const& type = b.get_type();
 
-		float alpha = 1 - (end - txt.dim.y) / 100.0;
+	x1 = ((dim.x - (dim.w / 2)) - 5) / 20;
+	x2 = ((dim.x + (dim.w / 2)) - 5) / 20;
+	y1 = ((dim.y - (dim.h / 2) + (type.height_d * 20)) - 60) / 20;
+	y2 = ((dim.y + (dim.h / 2)) - 60) / 20;
+}
 
-		Screen::get().fill(255, 255, 255, (uint8_t)(255 * alpha));
-		Screen::get().text(txt.text, sdl2::str_brygada, 20,
-			txt.dim.x, txt.dim.y, txt.align);
+void Base::raise_tiles(Building const& b, int cx1, int cy1, int cx2, int cy2)
+{
+	int x1, y1, x2, y2;
+	footprint(b, x1, y1, x2, y2);
+	x1 = std::max(x1, cx1);
+	y1 = std::max(y1, cy1);
+	x2 = std::min(x2, cx2);
+	y2 = std::min(y2, cy2);
+	if (x1 > x2 || y1 > y2)
+		return;
 
-		it->second.dim.y--;
+	auto const state = b.get_type().tile;
+	auto& layer = writable_tile_layer();
+	for (int i = y1; i <= y2; ++i)
+	{
+		for (int j = x1; j <= x2; ++j)
+		{
+			if (state <= tiles[i][j].state)
+				continue;
 
-		if (txt.dim.y <= end + 5)
-			it = resources_msg.erase(it);
-		else
-			++it;
+			tiles[i][j].state = state;
+			layer[i * TILES_X + j] = (uint8_t)state;
+		}
 	}
 }
 
-void Base::display_grid()
+void Base::update_farmers()
 {
-	int const sides = 9;
-	int const w = 70;
-	int const h = 50;
+	PROFILE_SCOPE("Base::update_farmers");
 
-	int const x_base = Screen::get().SCREEN_WIDTH / 2;
-	int const y_base = 60;
+	float const spd = 0.5f;
 
-	for (int i = 0; i < sides + 1; ++i)
+	// searches run as jobs, each with a stream split off in farmer order so
+	//   the paths don't depend on which worker gets them
+	path_requests.clear();
+	for (int i = 0; i < (int)farmers.size(); ++i)
 	{
-		int const x0_off = i * (w / 2);
-		int const y0_off = i * (h / 2);
-		int const x1_off = ((w / 2) * sides) - (i * w / 2);
-		int const y1_off = ((h / 2) * sides) + (i * h / 2);
+		if (farmers[i].path.empty())
+			path_requests.push_back({ i, rng[RngStream::PATHING].next() });
+	}
 
-		Screen::get().stroke(sdl2::clr_white);
+	Jobs::get().parallel_for(path_requests.size(), PATH_GRAIN, [&](int begin, int end) {
+		for (int i = begin; i < end; ++i)
+		{
+			Rng path_rng(path_requests[i].second);
+			farmers[path_requests[i].first].generate_path(tiles, path_rng);
+		}
+	});
 
-		Screen::get().line(
-			x_base - x0_off, y_base + y0_off,
-			x_base + x1_off, y_base + y1_off);
+	Jobs::get().parallel_for(farmers.size(), STEER_GRAIN, [&](int begin, int end) {
+		for (int i = begin; i < end; ++i)
+		{
+			auto& farmer = farmers[i];
+			auto const& dest = farmer.path[0];
+			if (farmer.steps_left == 0)
+			{
+				farmer.path_pos = farmer.path[0];
+				farmer.path.pop_front();
 
-		Screen::get().line(
-			x_base + x0_off, y_base + y0_off,
-			x_base - x1_off, y_base + y1_off);
-	}
+				farmer.steps_left = 20 / spd;
+			}
+			else
+			{
+				if (farmer.path_pos.x < dest.x)
+					farmer.actual_pos.x += spd;
+				else if (farmer.path_pos.x > dest.x)
+					farmer.actual_pos.x -= spd;
+				else if (farmer.path_pos.y < dest.y)
+					farmer.actual_pos.y += spd;
+				else if (farmer.path_pos.y > dest.y)
+					farmer.actual_pos.y -= spd;
+
+				farmer.steps_left--;
+			}
+		}
+	});
 }
 
-bool Base::shared_ptr_comp::operator() (std::shared_ptr<Building> const& a, std::shared_ptr<Building> const& b) const
+sdl2::Dimension Base::shop_dim(int type)
 {
-	return *a < *b;
-}
\ No newline at end of file
+	auto const& t = BuildingCatalog::get()[type];
+	return { 200 + (type * 400), Screen::get().SCREEN_HEIGHT - 150, t.w, t.h };
+}
@@ -0,0 +1,251 @@
+#include "base_store.hpp"
+#include "save.hpp"
+#include "mapped_file.hpp"
+#include "profiler.hpp"
+#include "rng.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+// one per put, a later record for the same player replaces the earlier
+struct IndexRecord
+{
+	uint64_t id;
+	int32_t troph;
+	int32_t reserved;
+};
+
+static_assert(sizeof(IndexRecord) == 16, "index records must stay packed");
+
+}
+
+BaseStore::BaseStore(std::size_t const _max_bytes)
+	: max_bytes(_max_bytes), bytes(0), index_file(nullptr)
+{
+
+}
+
+BaseStore::~BaseStore()
+{
+	if (index_file)
+		std::fclose(index_file);
+}
+
+bool BaseStore::open(std::string const& _dir)
+{
+	PROFILE_SCOPE("BaseStore::open");
+
+	dir = _dir;
+
+	std::error_code ec;
+	std::filesystem::create_directories(dir, ec);
+	if (ec)
+	{
+		std::cout << "[error] - could not create base store '" << dir << "': " << ec.message() << '\n';
+		return false;
+	}
+
+	std::string const index_path = dir + "/index";
+	std::size_t records = 0, index_size = 0;
+	{
+		MappedFile file;
+		if (file.open(index_path))
+		{
+			index_size = file.size();
+			records = index_size / sizeof(IndexRecord);
+			auto const* r = (IndexRecord const*)file.data();
+			for (std::size_t i = 0; i < records; ++i)
+				troph_of[r[i].id] = r[i].troph;
+		}
+	}
+
+	by_troph.clear();
+	by_troph.reserve(troph_of.size());
+	for (auto const& [id, troph] : troph_of)
+		by_troph.push_back({ troph, id });
+	std::sort(by_troph.begin(), by_troph.end());
+
+	// replaced records pile up, once they're most of the file it's rewritten
+	bool compacted = false;
+	if (records > 2 * troph_of.size() + 1024)
+	{
+		std::vector<IndexRecord> compact;
+		compact.reserve(by_troph.size());
+		for (auto const& [troph, id] : by_troph)
+			compact.push_back(IndexRecord{ id, troph, 0 });
+
+		compacted = save::write_file(index_path, (char const*)compact.data(), compact.size() * sizeof(IndexRecord), false);
+	}
+
+	if (!compacted && index_size % sizeof(IndexRecord) != 0)
+	{
+		// a crash mid append leaves part of a record, appending after it
+		//   would misalign every record from then on
+		std::filesystem::resize_file(index_path, records * sizeof(IndexRecord), ec);
+		if (ec)
+		{
+			std::cout << "[error] - could not truncate '" << index_path << "': " << ec.message() << '\n';
+			return false;
+		}
+	}
+
+	index_file = std::fopen(index_path.c_str(), "ab");
+	if (index_file == nullptr)
+	{
+		std::cout << "[error] - could not open '" << index_path << "'\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool BaseStore::put(uint64_t const id, save::Snapshot const& snap)
+{
+	PROFILE_SCOPE("BaseStore::put");
+
+	// a mapping of the old save would go stale
+	evict(id);
+
+	// rebuilt from the live bases if lost, so no fsync
+	auto const encoded = save::encode(snap);
+	if (!save::write_file(path_of(id), encoded.data(), encoded.size(), false))
+		return false;
+
+	IndexRecord const record{ id, snap.header.troph, 0 };
+	if (index_file == nullptr || std::fwrite(&record, sizeof(record), 1, index_file) != 1 || std::fflush(index_file) != 0)
+	{
+		std::cout << "[error] - could not index base " << id << '\n';
+		return false;
+	}
+
+	unindex(id);
+	index(id, snap.header.troph);
+	return true;
+}
+
+bool BaseStore::find_opponent(int const troph, uint64_t const exclude, Rng& rng, Rival& out)
+{
+	PROFILE_SCOPE("BaseStore::find_opponent");
+
+	auto key = [&](int64_t t, uint64_t id) {
+		return std::make_pair((int32_t)std::clamp<int64_t>(t, INT32_MIN, INT32_MAX), id);
+	};
+
+	for (int64_t range = MATCH_RANGE; !by_troph.empty(); range *= 2)
+	{
+		// a few picks before widening, a bad save is dropped from the index
+		//   so the bounds are looked up again each time
+		for (int tries = 0; tries < 4; ++tries)
+		{
+			auto const first = std::lower_bound(by_troph.begin(), by_troph.end(), key(troph - range, 0));
+			auto const last = std::upper_bound(by_troph.begin(), by_troph.end(), key(troph + range, UINT64_MAX));
+			if (first == last || (last - first == 1 && first->second == exclude))
+				break;
+
+			auto pick = first + rng.range(0, (last - first) - 1);
+			if (pick->second == exclude)
+				pick = pick + 1 == last ? first : pick + 1;
+
+			if (auto const* cached = load(pick->second))
+			{
+				out = Rival{ pick->second, cached->view, cached->file };
+				return true;
+			}
+		}
+
+		// the range already covers every trophy count there is
+		if (by_troph.empty() || (by_troph.front().first >= troph - range && by_troph.back().first <= troph + range))
+			return false;
+	}
+
+	return false;
+}
+
+int BaseStore::size() const
+{
+	return by_troph.size();
+}
+
+std::size_t BaseStore::mapped_bytes() const
+{
+	return bytes;
+}
+
+std::string BaseStore::path_of(uint64_t const id) const
+{
+	return dir + "/" + std::to_string(id) + ".sav";
+}
+
+void BaseStore::index(uint64_t const id, int32_t const troph)
+{
+	auto const entry = std::make_pair(troph, id);
+	by_troph.insert(std::lower_bound(by_troph.begin(), by_troph.end(), entry), entry);
+	troph_of[id] = troph;
+}
+
+void BaseStore::unindex(uint64_t const id)
+{
+	auto const it = troph_of.find(id);
+	if (it == troph_of.end())
+		return;
+
+	auto const entry = std::make_pair(it->second, id);
+	auto const pos = std::lower_bound(by_troph.begin(), by_troph.end(), entry);
+	if (pos != by_troph.end() && *pos == entry)
+		by_troph.erase(pos);
+	troph_of.erase(it);
+}
+
+BaseStore::Cached const* BaseStore::load(uint64_t const id)
+{
+	auto const hit = cache.find(id);
+	if (hit != cache.end())
+	{
+		lru.splice(lru.begin(), lru, hit->second.lru);
+		return &hit->second;
+	}
+
+	PROFILE_SCOPE("BaseStore::load");
+
+	auto file = std::make_shared<MappedFile>();
+	save::View v;
+	if (!file->open(path_of(id)) || !save::view(file->data(), file->size(), v))
+	{
+		std::cout << "[error] - base store has a bad save for " << id << ", dropping it\n";
+		unindex(id);
+		return nullptr;
+	}
+
+	bytes += file->size();
+	lru.push_front(id);
+	auto& cached = cache[id];
+	cached = Cached{ std::move(file), v, lru.begin() };
+
+	// the one just loaded is never evicted, even if it's bigger than the budget
+	while (bytes > max_bytes && lru.size() > 1)
+		evict(lru.back());
+
+	return &cached;
+}
+
+void BaseStore::evict(uint64_t const id)
+{
+	auto const it = cache.find(id);
+	if (it == cache.end())
+		return;
+
+	bytes -= it->second.file->size();
+	lru.erase(it->second.lru);
+	cache.erase(it);
+}
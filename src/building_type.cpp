@@ -0,0 +1,58 @@
+#include "building_type.hpp"
+#include "content.hpp"
+#include "content_data.hpp"
+
+#include <vector>
+
+char const* prod_img(ProdType const type)
+{
+	switch (type)
+	{
+	case ProdType::GOLD:
+		return "gold.png";
+	case ProdType::WHEAT:
+		return "wheat.png";
+	case ProdType::WOOD:
+		return "wood.png";
+	case ProdType::STONE:
+		return "stone.png";
+	case ProdType::IRON:
+		return "iron.png";
+	}
+
+	return "gold.png";
+}
+
+BuildingCatalog& BuildingCatalog::get()
+{
+	static BuildingCatalog instance;
+	return instance;
+}
+
+BuildingCatalog::BuildingCatalog()
+{
+	for (auto const& def : content::buildings)
+	{
+		add(BuildingType{
+			def.name, def.img, def.w, def.h, def.base_scale, def.height_d,
+			def.cost_gold, def.cost_wood, def.cost_stone, def.cost_iron, def.tile,
+			def.prod, def.prod_type, def.rate, def.display_cap, def.storage_cap
+		});
+	}
+}
+
+int BuildingCatalog::add(BuildingType const& type)
+{
+	types.push_back(type);
+	return (int)types.size() - 1;
+}
+
+BuildingType const& BuildingCatalog::operator[](int type) const
+{
+	return types[type];
+}
+
+int BuildingCatalog::size() const
+{
+	return (int)types.size();
+}
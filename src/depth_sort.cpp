@@ -0,0 +1,59 @@
+#include "depth_sort.hpp"
+
+#include <algorithm>
+#include <vector>
+
+DepthSort::DepthSort(int const _width, int const _height)
+	: width(_width), height(_height)
+{
+
+}
+
+void DepthSort::clear()
+{
+	drawables.clear();
+}
+
+void DepthSort::push(int x, int y, DrawKind const kind, int index)
+{
+	// sprites hanging off the screen still need a bucket
+	x = std::clamp(x, 0, width);
+	y = std::clamp(y, 0, height);
+
+	drawables.push_back(Drawable{ x, y, kind, index });
+}
+
+std::vector<Drawable> const& DepthSort::sort()
+{
+	// allocated on first use, headless bases are never sorted
+	if (counts.empty())
+		counts.resize(std::max(width, height) + 1);
+
+	sorted.resize(drawables.size());
+
+	// least significant key first, the row pass is stable so columns stay in order
+	counting_sort(drawables, sorted, false);
+	counting_sort(sorted, drawables, true);
+
+	return drawables;
+}
+
+void DepthSort::counting_sort(std::vector<Drawable> const& src, std::vector<Drawable>& dst, bool by_row)
+{
+	int const keys = (by_row ? height : width) + 1;
+	std::fill(counts.begin(), counts.begin() + keys, 0);
+
+	for (auto const& d : src)
+		counts[by_row ? d.y : d.x]++;
+
+	int total = 0;
+	for (int i = 0; i < keys; ++i)
+	{
+		int const c = counts[i];
+		counts[i] = total;
+		total += c;
+	}
+
+	for (auto const& d : src)
+		dst[counts[by_row ? d.y : d.x]++] = d;
+}
@@ -0,0 +1,87 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+FrameArena& FrameArena::get()
+{
+	static thread_local FrameArena arena;
+	return arena;
+}
+
+FrameArena::FrameArena()
+	: block(0), offset(0)
+{
+	blocks.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
+	block_sizes.push_back(BLOCK_SIZE);
+}
+
+void FrameArena::reset()
+{
+	block = 0;
+	offset = 0;
+}
+
+FrameArena::Mark FrameArena::mark() const
+{
+	return Mark{ block, offset };
+}
+
+void FrameArena::rewind(Mark const& m)
+{
+	block = m.block;
+	offset = m.offset;
+}
+
+std::size_t FrameArena::used() const
+{
+	std::size_t total = offset;
+	for (std::size_t i = 0; i < block; ++i)
+		total += block_sizes[i];
+
+	return total;
+}
+
+std::size_t FrameArena::capacity() const
+{
+	std::size_t total = 0;
+	for (auto size : block_sizes)
+		total += size;
+
+	return total;
+}
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t align)
+{
+	while (true)
+	{
+		auto const base = (uintptr_t)blocks[block].get();
+		auto const start = (base + offset + align - 1) & ~(uintptr_t)(align - 1);
+
+		if (start + bytes <= base + block_sizes[block])
+		{
+			offset = start + bytes - base;
+			return (void*)start;
+		}
+
+		// the rest of this block is wasted until the next reset
+		block++;
+		offset = 0;
+
+		// only grows while the arena is warming up to the biggest frame
+		if (block == blocks.size())
+		{
+			std::size_t const size = std::max(block_sizes.back() * 2, bytes + align);
+			blocks.push_back(std::make_unique<std::byte[]>(size));
+			block_sizes.push_back(size);
+		}
+	}
+}
+
+bool FrameArena::do_is_equal(std::pmr::memory_resource const& other) const noexcept
+{
+	return this == &other;
+}
@@ -0,0 +1,121 @@
+#include "input_log.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+char const MAGIC[4] = { 'N', 'K', 'I', 'L' };
+uint32_t const VERSION = 1;
+int const EVENT_SIZE = 13;
+
+void put(char*& p, uint64_t v, int bytes)
+{
+	for (int i = 0; i < bytes; ++i)
+		*p++ = (char)(v >> (i * 8));
+}
+
+uint64_t take(char const*& p, int bytes)
+{
+	uint64_t v = 0;
+	for (int i = 0; i < bytes; ++i)
+		v |= (uint64_t)(uint8_t)*p++ << (i * 8);
+	return v;
+}
+
+}
+
+bool InputRecorder::open(std::string const& path, uint64_t const seed)
+{
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "[error] - could not write input log '" << path << "'\n";
+		return false;
+	}
+
+	char header[16], *p = header;
+	std::memcpy(p, MAGIC, 4);
+	p += 4;
+	put(p, VERSION, 4);
+	put(p, seed, 8);
+
+	file.write(header, sizeof(header));
+	return (bool)file;
+}
+
+void InputRecorder::write(InputEvent const& e)
+{
+	if (!file.is_open())
+		return;
+
+	char buf[EVENT_SIZE], *p = buf;
+	put(p, e.frame, 4);
+	put(p, e.ms, 4);
+	put(p, (uint8_t)e.type, 1);
+	put(p, (uint16_t)e.x, 2);
+	put(p, (uint16_t)e.y, 2);
+
+	file.write(buf, EVENT_SIZE);
+}
+
+bool InputRecorder::is_open() const
+{
+	return file.is_open();
+}
+
+bool InputReplay::open(std::string const& path)
+{
+	file.open(path, std::ios::binary);
+
+	char header[16];
+	if (!file.read(header, sizeof(header)) || std::memcmp(header, MAGIC, 4) != 0)
+	{
+		std::cout << "[error] - '" << path << "' is not an input log\n";
+		return false;
+	}
+
+	char const* p = header + 4;
+	if (take(p, 4) != VERSION)
+	{
+		std::cout << "[error] - '" << path << "' is from an unsupported version\n";
+		return false;
+	}
+
+	seed = take(p, 8);
+	return true;
+}
+
+bool InputReplay::next_frame(std::vector<InputEvent>& events)
+{
+	events.clear();
+
+	char buf[EVENT_SIZE];
+	while (file.read(buf, EVENT_SIZE))
+	{
+		char const* p = buf;
+
+		InputEvent e;
+		e.frame = (uint32_t)take(p, 4);
+		e.ms = (uint32_t)take(p, 4);
+		e.type = (InputType)take(p, 1);
+		e.x = (int16_t)take(p, 2);
+		e.y = (int16_t)take(p, 2);
+
+		events.push_back(e);
+		if (e.type == InputType::FRAME)
+			return true;
+	}
+
+	return false;
+}
+
+uint64_t InputReplay::get_seed() const
+{
+	return seed;
+}
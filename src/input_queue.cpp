@@ -0,0 +1,57 @@
+#include "input_queue.hpp"
+#include "input_log.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+InputQueue::InputQueue()
+	: events{}, head(0), cached_tail(0), tail(0), cached_head(0)
+{
+
+}
+
+bool InputQueue::push(InputEvent const& e)
+{
+	uint32_t const t = tail.load(std::memory_order_relaxed);
+	if (t - cached_head == CAPACITY)
+	{
+		cached_head = head.load(std::memory_order_acquire);
+		if (t - cached_head == CAPACITY)
+			return false;
+	}
+
+	events[t & (CAPACITY - 1)] = e;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::pop(InputEvent& e)
+{
+	uint32_t const h = head.load(std::memory_order_relaxed);
+	if (h == cached_tail)
+	{
+		cached_tail = tail.load(std::memory_order_acquire);
+		if (h == cached_tail)
+			return false;
+	}
+
+	e = events[h & (CAPACITY - 1)];
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+void coalesce_drags(std::vector<InputEvent>& events)
+{
+	std::size_t n = 0;
+	for (std::size_t i = 0; i < events.size(); ++i)
+	{
+		bool const superseded = events[i].type == InputType::DRAG
+			&& i + 1 < events.size() && events[i + 1].type == InputType::DRAG;
+
+		if (!superseded)
+			events[n++] = events[i];
+	}
+
+	events.resize(n);
+}
@@ -0,0 +1,215 @@
+#include "jobs.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+// which deque the thread pushes to, 0 for threads that aren't workers
+thread_local int worker_index = 0;
+
+// tries before a worker with nothing to do goes to sleep
+int const SPINS = 64;
+
+}
+
+Jobs& Jobs::get()
+{
+	static Jobs instance;
+	return instance;
+}
+
+Jobs::Group::Group()
+	: pending(0)
+{
+
+}
+
+bool Jobs::Group::done() const
+{
+	return pending.load(std::memory_order_acquire) == 0;
+}
+
+Jobs::Jobs()
+	: queued(0), sleeping(0), stopping(false)
+{
+
+}
+
+Jobs::~Jobs()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	sleep_cv.notify_all();
+
+	for (auto& t : threads)
+		t.join();
+}
+
+void Jobs::start(int const workers)
+{
+	std::call_once(started, [&] {
+		for (int i = 0; i <= workers; ++i)
+			queues.push_back(std::make_unique<Queue>());
+
+		for (int i = 1; i <= workers; ++i)
+			threads.emplace_back(&Jobs::worker_loop, this, i);
+	});
+}
+
+int Jobs::size()
+{
+	start(std::max(0, (int)std::thread::hardware_concurrency() - 1));
+	return queues.size();
+}
+
+void Jobs::spawn(Group& group, std::function<void()> fn)
+{
+	group.pending.fetch_add(1, std::memory_order_relaxed);
+	push(Job{ std::move(fn), &group });
+}
+
+void Jobs::spawn_after(Group& after, Group& group, std::function<void()> fn)
+{
+	group.pending.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(after.mutex);
+		if (after.pending.load(std::memory_order_acquire) > 0)
+		{
+			after.after.push_back(Job{ std::move(fn), &group });
+			return;
+		}
+	}
+
+	push(Job{ std::move(fn), &group });
+}
+
+void Jobs::wait(Group& group)
+{
+	PROFILE_SCOPE("Jobs::wait");
+
+	Job job;
+	while (!group.done())
+	{
+		if (pop(job))
+			run(job);
+		else
+			std::this_thread::yield();
+	}
+
+	// the last job may still be unlocking the group, which is about to go away
+	std::lock_guard<std::mutex> lock(group.mutex);
+}
+
+void Jobs::push(Job job)
+{
+	size();
+
+	{
+		auto& q = *queues[worker_index];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		q.jobs.push_back(std::move(job));
+	}
+
+	// paired with the sleeper bumping sleeping before it checks queued, one
+	//   of the two always sees the other
+	queued.fetch_add(1);
+	if (sleeping.load() > 0)
+	{
+		{ std::lock_guard<std::mutex> lock(sleep_mutex); }
+		sleep_cv.notify_one();
+	}
+}
+
+bool Jobs::pop(Job& job)
+{
+	if (queued.load(std::memory_order_relaxed) == 0)
+		return false;
+
+	// newest of our own, it's the most likely to still be in cache
+	{
+		auto& q = *queues[worker_index];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.jobs.empty())
+		{
+			job = std::move(q.jobs.back());
+			q.jobs.pop_back();
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// oldest of someone else's, it's the most likely to fork more work
+	int const n = queues.size();
+	for (int i = 1; i < n; ++i)
+	{
+		auto& q = *queues[(worker_index + i) % n];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.jobs.empty())
+		{
+			job = std::move(q.jobs.front());
+			q.jobs.pop_front();
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Jobs::run(Job& job)
+{
+	job.fn();
+	job.fn = nullptr;
+
+	// the count drops under the lock so spawn_after can't miss the end
+	auto& group = *job.group;
+	std::vector<Job> next;
+	{
+		std::lock_guard<std::mutex> lock(group.mutex);
+		if (group.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			next.swap(group.after);
+	}
+
+	for (auto& j : next)
+		push(std::move(j));
+}
+
+void Jobs::worker_loop(int const index)
+{
+	worker_index = index;
+
+	Job job;
+	int idle = 0;
+	while (!stopping.load(std::memory_order_relaxed))
+	{
+		if (pop(job))
+		{
+			run(job);
+			idle = 0;
+			continue;
+		}
+
+		if (++idle < SPINS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleeping.fetch_add(1);
+		sleep_cv.wait(lock, [&] { return stopping || queued.load() > 0; });
+		sleeping.fetch_sub(1);
+		idle = 0;
+	}
+}
@@ -0,0 +1,276 @@
+#include "journal.hpp"
+#include "base.hpp"
+#include "save.hpp"
+#include "profiler.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+char const MAGIC[4] = { 'N', 'K', 'J', 'L' };
+uint32_t const VERSION = 1;
+int const HEADER_SIZE = 16;
+
+// fnv-1a
+uint32_t checksum(void const* data, std::size_t size)
+{
+	uint32_t h = 2166136261u;
+	for (std::size_t i = 0; i < size; ++i)
+		h = (h ^ ((uint8_t const*)data)[i]) * 16777619u;
+	return h;
+}
+
+bool sync(FILE* file)
+{
+	if (std::fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+}
+
+Journal::Journal()
+	: file(nullptr), seq(0), records_since_compact(0), stopping(false)
+{
+
+}
+
+Journal::~Journal()
+{
+	if (writer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cv.notify_one();
+		writer.join();
+	}
+
+	if (file)
+		std::fclose(file);
+}
+
+bool Journal::open(Base& base, std::string const& _save_path, std::string const& _journal_path)
+{
+	PROFILE_SCOPE("Journal::open");
+
+	save_path = _save_path;
+	journal_path = _journal_path;
+
+	// a missing save is a new base, anything in the journal still applies
+	// one that's there but won't load, corrupt or from an older version, is
+	//   left alone, folding would overwrite it with an empty base
+	uint64_t save_seq = 0;
+	std::error_code ec;
+	if (std::filesystem::exists(save_path, ec) && !save::load(base, save_path, &save_seq))
+	{
+		std::cout << "[error] - could not load '" << save_path << "', not overwriting it\n";
+		return false;
+	}
+
+	seq = replay(base, (uint32_t)save_seq);
+
+	// fold the replayed actions in straight away, which also drops a torn tail
+	auto snap = base.snapshot();
+	snap.header.journal_seq = seq;
+	auto const bytes = save::encode(snap);
+	if (!save::write_file(save_path, bytes.data(), bytes.size()) || !write_journal(seq, {}))
+		return false;
+
+	file = std::fopen(journal_path.c_str(), "ab");
+	if (file == nullptr)
+	{
+		std::cout << "[error] - could not open journal '" << journal_path << "'\n";
+		return false;
+	}
+
+	writer = std::thread(&Journal::writer_loop, this);
+	return true;
+}
+
+void Journal::close(Base const& base)
+{
+	if (!writer.joinable())
+		return;
+
+	compact(base);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	cv.notify_one();
+	writer.join();
+
+	if (file)
+		std::fclose(file);
+	file = nullptr;
+}
+
+void Journal::append(Action const& action)
+{
+	Record r{ ++seq, (uint16_t)action.type, 0, action.a, action.b, action.c, 0 };
+	r.checksum = checksum(&r, offsetof(Record, checksum));
+
+	records_since_compact++;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.push_back(r);
+}
+
+bool Journal::should_compact() const
+{
+	return records_since_compact >= COMPACT_RECORDS;
+}
+
+void Journal::compact(Base const& base)
+{
+	auto snap = std::make_unique<save::Snapshot>(base.snapshot());
+	snap->header.journal_seq = seq;
+	records_since_compact = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		compact_snap = std::move(snap);
+	}
+	cv.notify_one();
+}
+
+void Journal::writer_loop()
+{
+	std::vector<Record> batch;
+
+	while (true)
+	{
+		std::unique_ptr<save::Snapshot> snap;
+		bool stop;
+		{
+			// appends don't wake the writer, they pile up into one group
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait_for(lock, std::chrono::milliseconds(GROUP_COMMIT_MS), [&] { return stopping || compact_snap; });
+
+			batch.swap(pending);
+			snap = std::move(compact_snap);
+			stop = stopping;
+		}
+
+		if (!batch.empty() && file)
+		{
+			PROFILE_SCOPE("Journal::group_commit");
+
+			if (std::fwrite(batch.data(), sizeof(Record), batch.size(), file) != batch.size() || !sync(file))
+				std::cout << "[error] - could not write journal '" << journal_path << "'\n";
+		}
+
+		if (snap)
+		{
+			PROFILE_SCOPE("Journal::compact");
+
+			uint32_t const snap_seq = (uint32_t)snap->header.journal_seq;
+			auto const bytes = save::encode(*snap);
+
+			// the save goes first, if it fails the old journal still has everything
+			if (save::write_file(save_path, bytes.data(), bytes.size()))
+			{
+				std::vector<Record> rest;
+				for (auto const& r : batch)
+				{
+					if (r.seq > snap_seq)
+						rest.push_back(r);
+				}
+
+				if (file)
+					std::fclose(file);
+				write_journal(snap_seq, rest);
+				file = std::fopen(journal_path.c_str(), "ab");
+				if (file == nullptr)
+					std::cout << "[error] - could not reopen journal '" << journal_path << "'\n";
+			}
+		}
+
+		batch.clear();
+
+		if (stop)
+			break;
+	}
+}
+
+bool Journal::write_journal(uint32_t base_seq, std::vector<Record> const& records)
+{
+	std::vector<char> bytes(HEADER_SIZE + records.size() * sizeof(Record));
+	std::memcpy(bytes.data(), MAGIC, 4);
+	std::memcpy(bytes.data() + 4, &VERSION, 4);
+	std::memcpy(bytes.data() + 8, &base_seq, 4);
+	if (!records.empty())
+		std::memcpy(bytes.data() + HEADER_SIZE, records.data(), records.size() * sizeof(Record));
+
+	return save::write_file(journal_path, bytes.data(), bytes.size());
+}
+
+uint32_t Journal::replay(Base& base, uint32_t after_seq)
+{
+	std::ifstream in(journal_path, std::ios::binary);
+	if (!in)
+		return after_seq;
+
+	std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	uint32_t version = 0;
+	if (bytes.size() >= HEADER_SIZE)
+		std::memcpy(&version, bytes.data() + 4, 4);
+
+	if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), MAGIC, 4) != 0 || version != VERSION)
+	{
+		std::cout << "[error] - '" << journal_path << "' is not a journal from this version\n";
+		return after_seq;
+	}
+
+	uint32_t last = after_seq;
+	int replayed = 0;
+	for (std::size_t off = HEADER_SIZE; off + sizeof(Record) <= bytes.size(); off += sizeof(Record))
+	{
+		Record r;
+		std::memcpy(&r, bytes.data() + off, sizeof(Record));
+
+		// a torn or corrupt record ends the journal, as does a gap
+		if (r.checksum != checksum(&r, offsetof(Record, checksum)))
+			break;
+		if (r.seq <= last)
+			continue;
+		if (r.seq != last + 1)
+			break;
+
+		base.apply(Action{ (ActionType)r.type, r.a, r.b, r.c });
+		last = r.seq;
+		replayed++;
+	}
+
+	if (replayed > 0)
+		std::cout << "recovered " << replayed << " actions from '" << journal_path << "'\n";
+
+	return last;
+}
@@ -2,16 +2,130 @@
 #include "tile.hpp"
 #include "screen.hpp"
 #include "sdl2.hpp"
+#include "profiler.hpp"
+#include "overlay.hpp"
+#include "alloc_tracker.hpp"
+#include "input_log.hpp"
+#include "scene_gen.hpp"
+#include "journal.hpp"
+#include "autosave.hpp"
+#include "input_queue.hpp"
+#include "render_snapshot.hpp"
+#include "renderer.hpp"
+#include "frame_arena.hpp"
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// the sim runs at a fixed rate, independent of how fast frames are drawn
+int const TICKS_PER_SECOND = 60;
+auto const TICK = std::chrono::nanoseconds(1000000000 / TICKS_PER_SECOND);
+
+// tick times of a replay, printed as one json line when the log runs out
+void print_replay_summary(std::vector<float>& frame_ms)
+{
+	if (frame_ms.empty())
+		return;
+
+	std::sort(frame_ms.begin(), frame_ms.end());
+	auto pct = [&](double p) { return frame_ms[std::min(frame_ms.size() - 1, (std::size_t)(p * frame_ms.size()))]; };
+
+	double total = 0;
+	for (float ms : frame_ms)
+		total += ms;
+
+	std::printf("{\"frames\": %zu, \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f, "
+		"\"p99_ms\": %.3f, \"max_ms\": %.3f}\n",
+		frame_ms.size(), total / frame_ms.size(), pct(0.5), pct(0.9), pct(0.99), frame_ms.back());
+}
+
+}
 
 int main(int argc, char* argv[])
 {
+	// --profile <file> writes a chrome trace of the session on exit
+	// --alloc-budget <n> logs frames making more than n heap allocations,
+	//   --alloc-assert aborts on them instead (needs KINGDOM_TRACK_ALLOCS)
+	//   a frame is charged for every thread's allocations while it was drawn,
+	//   the sim, job workers and autosave included, not only the renderer's
+	// --record <file> saves the session's input, --replay <file> plays it back
+	//   at the recorded pace, or as fast as possible with --fast
+	// --seed <n> seeds the random streams, replays use the recorded seed
+	// --stress <buildings=n,villagers=n,particles=n,w=n,h=n,seed=n> starts in a
+	//   generated scene instead of the empty base
+	// --save <file> loads the base from file and keeps it saved, every action
+	//   is journaled to <file>.journal and folded into the save periodically
+	// --autosave <file> writes a compressed save every 10 s in the background
+	std::string trace_path, record_path, replay_path, save_path, autosave_path;
+	std::size_t alloc_budget = alloc::NO_BUDGET;
+	auto alloc_action = alloc::BudgetAction::LOG;
+	bool fast = false;
+	std::unique_ptr<StressScene> stress;
+	uint64_t seed = std::random_device{}();
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+			trace_path = argv[++i];
+		else if (std::strcmp(argv[i], "--alloc-budget") == 0 && i + 1 < argc)
+			alloc_budget = std::strtoul(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--alloc-assert") == 0)
+			alloc_action = alloc::BudgetAction::ASSERT;
+		else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+			record_path = argv[++i];
+		else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+			replay_path = argv[++i];
+		else if (std::strcmp(argv[i], "--fast") == 0)
+			fast = true;
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+			save_path = argv[++i];
+		else if (std::strcmp(argv[i], "--autosave") == 0 && i + 1 < argc)
+			autosave_path = argv[++i];
+		else if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc)
+		{
+			SceneConfig config;
+			if (!parse_scene_config(argv[++i], config))
+				return 1;
+			stress = std::make_unique<StressScene>(config);
+		}
+	}
+
+	prof::set_enabled(!trace_path.empty());
+	alloc::set_frame_budget(alloc_budget, alloc_action);
+
+	InputRecorder recorder;
+	InputReplay replay;
+	bool const replaying = !replay_path.empty();
+
+	if (replaying)
+	{
+		if (!replay.open(replay_path))
+			return 1;
+		seed = replay.get_seed();
+	}
+	else if (!record_path.empty() && !recorder.open(record_path, seed))
+		return 1;
+
+	Base::get().seed(seed);
+
 	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 	{
 		std::cout << "error - failed to initialize SDL\n    " << SDL_GetError();
@@ -27,36 +141,201 @@ int main(int argc, char* argv[])
 	SDL_PumpEvents();
 
 	Screen::get().set_window();
-	Base::get().set_building_dim();
 
-	Uint64 timer_second = SDL_GetTicks64();
-	
-	bool tutorial = true;
-	
+	std::unique_ptr<Autosave> autosave;
+	if (!autosave_path.empty())
+		autosave = std::make_unique<Autosave>(autosave_path, 10000);
+
+	Journal journal;
+	if (!save_path.empty())
+	{
+		if (!journal.open(Base::get(), save_path, save_path + ".journal"))
+			return 1;
+		Base::get().on_action = [&](Action const& action) { journal.append(action); };
+	}
+
+	if (stress)
+	{
+		// the scene has its own seed, the session's still drives the sim
+		stress->generate();
+		Base::get().seed(seed);
+
+		// generating isn't journaled, so the save has to catch up first
+		if (!save_path.empty())
+			journal.compact(Base::get());
+	}
+
+	Uint64 const session_start = SDL_GetTicks64();
+
+	// the sim thread owns Base and Particles from here until it's joined,
+	//   this thread only sees them through the snapshots it publishes
+	SnapshotBuffer snapshots;
+	std::atomic<bool> running = true;
+	std::atomic<bool> replay_done = false;
+
+	InputQueue inputs; // from the event loop, drained at the start of every tick
+
+	std::vector<float> replay_tick_ms;
+
+	std::thread sim([&] {
+		bool tutorial = true;
+		bool second_passed = false;
+		uint32_t tick = 0;
+
+		std::vector<InputEvent> events;
+
+		auto now_ms = [&] { return (uint32_t)(SDL_GetTicks64() - session_start); };
+
+		// every input goes through here, so recording sees exactly what Base sees
+		// ms is when it happened, inputs keep the time the event loop stamped
+		auto dispatch = [&](InputType type, uint32_t ms, int x = 0, int y = 0) {
+			recorder.write(InputEvent{ tick, ms, type, (int16_t)x, (int16_t)y });
+
+			switch (type)
+			{
+			case InputType::DOWN:
+				tutorial = false;
+				break;
+			case InputType::PRESS:
+				Base::get().handle_mouse_pressed(x, y);
+				break;
+			case InputType::DRAG:
+				Base::get().handle_mouse_dragged(x, y);
+				break;
+			case InputType::RELEASE:
+				Base::get().handle_mouse_released(x, y);
+				break;
+			case InputType::SECOND:
+				second_passed = true;
+				break;
+			case InputType::FRAME:
+				break;
+			}
+		};
+
+		auto next_tick = std::chrono::steady_clock::now();
+		while (running.load(std::memory_order_relaxed))
+		{
+			PROFILE_SCOPE("tick");
+
+			// a replay is paced by its recorded times instead
+			if (!replaying)
+			{
+				std::this_thread::sleep_until(next_tick);
+
+				// after a stall, catch up to now rather than running a burst of ticks
+				next_tick = std::max(next_tick + TICK, std::chrono::steady_clock::now());
+			}
+
+			uint64_t const tick_start = prof::now_ns();
+
+			second_passed = false;
+
+			if (replaying)
+			{
+				if (!replay.next_frame(events))
+				{
+					replay_done = true;
+					break;
+				}
+
+				// wait for the recorded time of the tick, its FRAME event is last
+				if (!fast)
+				{
+					while (SDL_GetTicks64() - session_start < events.back().ms)
+						SDL_Delay(1);
+				}
+
+				for (auto const& e : events)
+					dispatch(e.type, e.ms, e.x, e.y);
+			}
+			else
+			{
+				// only what arrived before the tick started, anything later
+				//   waits for the next boundary
+				events.clear();
+				InputEvent e;
+				while (inputs.pop(e))
+					events.push_back(e);
+				coalesce_drags(events);
+
+				for (auto const& e : events)
+					dispatch(e.type, e.ms, e.x, e.y);
+
+				if (tick % TICKS_PER_SECOND == TICKS_PER_SECOND - 1)
+					dispatch(InputType::SECOND, now_ms());
+			}
+
+			Base::get().tick(second_passed);
+			Base::get().update_ui();
+
+			if (stress)
+				stress->update();
+
+			if (journal.should_compact())
+				journal.compact(Base::get());
+
+			if (autosave)
+				autosave->update(Base::get());
+
+			auto& snap = snapshots.back();
+			Base::get().capture(snap);
+			snap.tick = tick;
+			snap.tutorial = tutorial;
+			snap.sim_ns = prof::now_ns() - tick_start;
+			snapshots.publish();
+
+			if (!replaying)
+				dispatch(InputType::FRAME, now_ms());
+			else
+				replay_tick_ms.push_back((prof::now_ns() - tick_start) / 1e6f);
+
+			FrameArena::get().reset();
+			tick++;
+		}
+	});
+
 	bool left_mouse_down = true;
+	bool dragging = false;
 	Uint64 timer_mouse_drag = SDL_GetTicks64();
 
-	int frame_count = 0;
-	int fps = 0;
-	Uint64 timer_fps = SDL_GetTicks64();
-
 	short const MOUSE_DRAG_THRESHOLD = 100;
 
+	// timestamp is SDL's, ms since it was initialized
+	auto push_input = [&](Uint64 timestamp, InputType type, int x = 0, int y = 0) {
+		// only a flood of drags can fill the ring, and the next one replaces them
+		if (!inputs.push(InputEvent{ 0, (uint32_t)(timestamp - session_start), type, (int16_t)x, (int16_t)y }))
+			std::cout << "[error] - input queue full, dropped an input\n";
+	};
+
+	auto quit = [&] {
+		running = false;
+		sim.join();
+
+		if (replay_done)
+			print_replay_summary(replay_tick_ms);
+		if (!save_path.empty())
+			journal.close(Base::get());
+		if (!trace_path.empty())
+			prof::write_chrome_trace(trace_path);
+		return 0;
+	};
+
 	while (true)
 	{
-		frame_count++;
-	    if (SDL_GetTicks64() - timer_fps > 1000)
-	    {
-			timer_fps = SDL_GetTicks64();
-			fps = frame_count;
-			frame_count = 0;
-	    }
-		
+		PROFILE_SCOPE("frame");
+
+		uint64_t const frame_start = prof::now_ns();
+
 		Screen::get().clear();
 
 		SDL_Event event;
 		while (SDL_PollEvent(&event))
 		{
+			// a replay only listens for quitting and the overlay
+			if (replaying && event.type != SDL_KEYDOWN && event.type != SDL_QUIT)
+				continue;
+
 			switch (event.type)
 			{
 			case SDL_MOUSEBUTTONDOWN:
@@ -65,9 +344,10 @@ int main(int argc, char* argv[])
 					break;
 
 				left_mouse_down = true;
-				timer_mouse_drag = SDL_GetTicks64();
+				dragging = false;
+				timer_mouse_drag = event.button.timestamp;
 
-				tutorial = false;
+				push_input(event.button.timestamp, InputType::DOWN);
 				
 				break;
 			}
@@ -77,70 +357,66 @@ int main(int argc, char* argv[])
 					break;
 
 				left_mouse_down = false;
+				dragging = false;
 
-				int x, y;
-				SDL_GetMouseState(&x, &y);
-
-				if (SDL_GetTicks() - timer_mouse_drag < MOUSE_DRAG_THRESHOLD)
-					Base::get().handle_mouse_pressed(x, y);
+				int const x = event.button.x, y = event.button.y;
+				if (event.button.timestamp - timer_mouse_drag < MOUSE_DRAG_THRESHOLD)
+					push_input(event.button.timestamp, InputType::PRESS, x, y);
 				else
-					Base::get().handle_mouse_released(x, y);
+					push_input(event.button.timestamp, InputType::RELEASE, x, y);
+
+				break;
+			}
+			case SDL_MOUSEMOTION:
+			{
+				if (dragging)
+					push_input(event.motion.timestamp, InputType::DRAG, event.motion.x, event.motion.y);
+
+				break;
+			}
+			case SDL_KEYDOWN:
+			{
+				if (event.key.keysym.sym == SDLK_F3)
+					Overlay::get().toggle();
 
 				break;
 			}
 			case SDL_QUIT:
-				return 0;
+				return quit();
 			default:
 				break;
 			}
 		}
 
-		if (left_mouse_down && SDL_GetTicks64() - timer_mouse_drag >= MOUSE_DRAG_THRESHOLD)
+		if (replay_done)
+			return quit();
+
+		// a held button becomes a drag once, after that only moving sends more
+		if (!replaying && left_mouse_down && !dragging && SDL_GetTicks64() - timer_mouse_drag >= MOUSE_DRAG_THRESHOLD)
 		{
 			int x, y;
 			SDL_GetMouseState(&x, &y);
-			Base::get().handle_mouse_dragged(x, y);
+			push_input(SDL_GetTicks64(), InputType::DRAG, x, y);
+			dragging = true;
 		}
 
-		if (tutorial)
-		{
-			Screen::get().fill(sdl2::clr_black);
-			Screen::get().stroke(sdl2::clr_white);
-			Screen::get().rect(100, 80, 850, 200);
-		}
+		// the newest tick, or the one drawn last frame if the sim hasn't
+		//   finished another
+		RenderSnapshot const* snap = snapshots.acquire();
+		if (snap != nullptr)
+			Renderer::get().draw(*snap);
 
-		Base::get().display_resources();
-
-		if (tutorial)
-		{
-			Screen::get().fill(sdl2::clr_yellow);
-			Screen::get().text_font(sdl2::str_brygada);
-			Screen::get().text_align(sdl2::TextAlign::CENTER_LEFT);
-
-			Screen::get().text_size(24);
-			Screen::get().text("Welcome to Nighthawk: Kingdoms!", 120, 100);
-
-			Screen::get().text_size(24);
-			Screen::get().text("Here you can build your own kingdom and collect resources!", 120, 140);
-
-			Screen::get().text_size(24);
-			Screen::get().text("Click the shop button to place your first building, then you are good to go!", 120, 180);
-		}
-
-		bool second_passed = SDL_GetTicks64() - timer_second >= 1000;
-		if (second_passed)
-			timer_second = SDL_GetTicks64();
-
-		Base::get().display_scene(second_passed);
-		Base::get().display_shop();
-
-		Screen::get().fill(sdl2::clr_white);
-		Screen::get().text_size(10);
-		Screen::get().text_font(sdl2::str_brygada);
-		Screen::get().text_align(sdl2::TextAlign::CENTER_LEFT);
-		Screen::get().text("frames: " + std::to_string(frame_count), 10, Screen::get().SCREEN_HEIGHT - 20);
+		uint64_t const render_end = prof::now_ns();
 
+		Overlay::get().display();
 
+		uint64_t const present_start = prof::now_ns();
 		Screen::get().update();
+		uint64_t const present_end = prof::now_ns();
+
+		Overlay::get().end_frame(present_end - frame_start, snap != nullptr ? snap->sim_ns : 0,
+			(render_end - frame_start) + (present_start - render_end),
+			present_end - present_start,
+			Screen::get().last_frame_stats(), alloc::end_frame());
 	}
 }
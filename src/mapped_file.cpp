@@ -0,0 +1,149 @@
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: ptr(nullptr), len(0)
+#ifdef _WIN32
+	, file(nullptr), mapping(nullptr)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: MappedFile()
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(ptr, other.ptr);
+		std::swap(len, other.len);
+#ifdef _WIN32
+		std::swap(file, other.file);
+		std::swap(mapping, other.mapping);
+#endif
+	}
+
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(std::string const& path)
+{
+	close();
+
+	HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (f == INVALID_HANDLE_VALUE)
+		return false;
+	file = f;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(f, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	ptr = (char const*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	len = ptr ? (std::size_t)size.QuadPart : 0;
+	if (ptr == nullptr)
+		close();
+
+	return ptr != nullptr;
+}
+
+void MappedFile::close()
+{
+	if (ptr)
+		UnmapViewOfFile(ptr);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+
+	ptr = nullptr;
+	len = 0;
+	file = nullptr;
+	mapping = nullptr;
+}
+
+#else
+
+bool MappedFile::open(std::string const& path)
+{
+	close();
+
+	int const fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// the mapping keeps its own reference, the descriptor isn't needed after
+	void* p = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if (p == MAP_FAILED)
+		return false;
+
+	ptr = (char const*)p;
+	len = (std::size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (ptr)
+		munmap((void*)ptr, len);
+
+	ptr = nullptr;
+	len = 0;
+}
+
+#endif
+
+char const* MappedFile::data() const
+{
+	return ptr;
+}
+
+std::size_t MappedFile::size() const
+{
+	return len;
+}
@@ -0,0 +1,119 @@
+#include "overlay.hpp"
+#include "screen.hpp"
+#include "sdl2.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+Overlay& Overlay::get()
+{
+	static Overlay instance;
+	return instance;
+}
+
+Overlay::Overlay()
+	: visible(false)
+	, frame_ms{}, frame_head(0), frame_count(0)
+	, sim_ms(0), render_ms(0), present_ms(0)
+	, stats{}, allocs(0)
+{
+
+}
+
+void Overlay::toggle()
+{
+	visible = !visible;
+}
+
+void Overlay::end_frame(uint64_t frame_ns, uint64_t sim_ns, uint64_t render_ns, uint64_t present_ns,
+	Screen::Stats const& _stats, std::size_t _allocs)
+{
+	sim_ms = sim_ns / 1e6f;
+	render_ms = render_ns / 1e6f;
+	present_ms = present_ns / 1e6f;
+	stats = _stats;
+	allocs = _allocs;
+
+	frame_ms[frame_head] = frame_ns / 1e6f;
+	frame_head = (frame_head + 1) % FRAMES;
+	frame_count = std::min(frame_count + 1, FRAMES);
+}
+
+void Overlay::display()
+{
+	if (!visible)
+		return;
+
+	auto& screen = Screen::get();
+	screen.pause_stats(true);
+
+	int const x = 10, w = FRAMES * 2, graph_h = 60;
+	int const y = screen.SCREEN_HEIGHT - graph_h - 110;
+	float const budget_ms = 1000 / 60.f;
+
+	screen.fill(0, 0, 0, 170);
+	screen.stroke(sdl2::clr_clear);
+	screen.rect_align(sdl2::RectAlign::CORNERS);
+	screen.rect(x - 5, y - 5, w + 10, graph_h + 110);
+
+	// oldest on the left, bars over the 60 fps budget are red
+	for (int i = 0; i < frame_count; ++i)
+	{
+		float const ms = frame_ms[(frame_head - frame_count + i + FRAMES) % FRAMES];
+		int const h = std::min(graph_h, (int)(ms / (budget_ms * 2) * graph_h));
+
+		if (ms > budget_ms)
+			screen.fill(sdl2::clr_red);
+		else
+			screen.fill(sdl2::clr_green);
+		screen.rect(x + i * 2, y + graph_h - h, 2, h);
+	}
+
+	screen.fill(sdl2::clr_white);
+	screen.rect(x, y + graph_h / 2, w, 1);
+
+	char line[128];
+	screen.text_font(sdl2::str_brygada);
+	screen.text_size(12);
+	screen.text_align(sdl2::TextAlign::CORNERS);
+
+	float const p50 = percentile(0.5f), p99 = percentile(0.99f), max = percentile(1);
+	std::snprintf(line, sizeof(line), "fps %.0f   p50 %.2f ms   p99 %.2f ms   max %.2f ms",
+		p50 > 0 ? 1000 / p50 : 0, p50, p99, max);
+	screen.text_cached(line, x, y + graph_h + 5);
+
+	std::snprintf(line, sizeof(line), "render %.2f ms   present %.2f ms   sim %.2f ms (own thread)",
+		render_ms, present_ms, sim_ms);
+	screen.text_cached(line, x, y + graph_h + 25);
+
+#ifdef KINGDOM_TRACK_ALLOCS
+	std::snprintf(line, sizeof(line), "draws %lld (avg %.0f)   binds %lld   states %lld   allocs %zu",
+		(long long)stats.draw_calls, screen.average_stats(&Screen::Stats::draw_calls),
+		(long long)stats.texture_binds, (long long)stats.state_changes, allocs);
+#else
+	std::snprintf(line, sizeof(line), "draws %lld (avg %.0f)   binds %lld   states %lld   allocs -",
+		(long long)stats.draw_calls, screen.average_stats(&Screen::Stats::draw_calls),
+		(long long)stats.texture_binds, (long long)stats.state_changes);
+#endif
+	screen.text_cached(line, x, y + graph_h + 45);
+
+	std::snprintf(line, sizeof(line), "points %lld   uploads %lld (%lld kb)   text %lld",
+		(long long)stats.points, (long long)stats.texture_uploads,
+		(long long)stats.bytes_uploaded / 1024, (long long)stats.text_rasterizations);
+	screen.text_cached(line, x, y + graph_h + 65);
+
+	screen.pause_stats(false);
+}
+
+float Overlay::percentile(float p)
+{
+	if (frame_count == 0)
+		return 0;
+
+	std::copy(frame_ms.begin(), frame_ms.begin() + frame_count, sorted.begin());
+
+	int const k = std::min(frame_count - 1, (int)(p * frame_count));
+	std::nth_element(sorted.begin(), sorted.begin() + k, sorted.begin() + frame_count);
+
+	return sorted[k];
+}
@@ -0,0 +1,90 @@
+#include "particles.hpp"
+#include "render_snapshot.hpp"
+
+#include <algorithm>
+#include <vector>
+
+Particles& Particles::get()
+{
+	static Particles instance;
+	return instance;
+}
+
+Particles::Particles()
+	: count(0)
+{
+
+}
+
+void Particles::spawn(Rng& rng, ProdType const _sprite, int _x, int _y, int n)
+{
+	n = std::min(n, CAPACITY - count);
+
+	// random columns are filled in bulk, straight into the pool
+	rng.fill_uniform(&x[count], n, -20, 20);
+	rng.fill_uniform(&vx[count], n, -1, 1);
+	rng.fill_uniform(&ay[count], n, 0.025f, 0.05f);
+
+	for (int i = count; i < count + n; ++i)
+	{
+		x[i] += _x;		y[i]  = _y;
+						vy[i] = -2;
+		ax[i] = 0;
+		jx[i] = 0;		jy[i] = 0.0003f;
+		alpha[i] = 255;
+		sprite[i] = _sprite;
+	}
+
+	count += n;
+}
+
+void Particles::update()
+{
+	int const n = count;
+
+	// no branches or aliasing so the compiler can vectorize it
+	for (int i = 0; i < n; ++i)
+	{
+		x[i] += vx[i];
+		y[i] += vy[i];
+
+		vx[i] += ax[i];
+		vy[i] += ay[i];
+
+		ax[i] += jx[i];
+		ay[i] += jy[i];
+
+		alpha[i] -= 2.5f;
+	}
+
+	for (int i = count - 1; i >= 0; --i)
+	{
+		if (alpha[i] <= 0)
+			remove(i);
+	}
+}
+
+void Particles::capture(std::vector<RenderSnapshot::Particle>& out) const
+{
+	out.resize(count);
+	for (int i = 0; i < count; ++i)
+		out[i] = RenderSnapshot::Particle{ x[i], y[i], alpha[i], sprite[i] };
+}
+
+int Particles::size() const
+{
+	return count;
+}
+
+// swap with the last particle, order doesn't matter
+void Particles::remove(int i)
+{
+	int const last = --count;
+
+	x[i]  = x[last];  y[i]  = y[last];
+	vx[i] = vx[last]; vy[i] = vy[last];
+	ax[i] = ax[last]; ay[i] = ay[last];
+	jx[i] = jx[last]; jy[i] = jy[last];
+	alpha[i] = alpha[last];
+	sprite[i] = sprite[last];
+}
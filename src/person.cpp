@@ -1,96 +1,121 @@
 #include "person.hpp"
-#include "base.hpp"
+#include "profiler.hpp"
+#include "frame_arena.hpp"
 
 #include <SDL.h>
 
-#include <random>
+#include <algorithm>
 #include <vector>
 #include <queue>
 #include <iostream>
 
-void Person::generate_path(std::vector<std::vector<Tile>> const& tiles)
+namespace
 {
-	int destx = path_pos.x, desty = path_pos.y;
-	while (destx == path_pos.x && desty == path_pos.y)
-	{
-		destx = distrx(eng);
-		desty = distry(eng);
-	}
 
-	std::vector<std::vector<int>> costs(tiles.size(), std::vector<int>(tiles[0].size()));
-	std::vector<std::vector<bool>> been(tiles.size(), std::vector<bool>(tiles[0].size(), false));
-	for (int i = 0; i < costs.size(); ++i)
+// appends the walk from start to dest, false if dest can't be reached
+bool search(std::vector<std::vector<Tile>> const& tiles, SDL_Point const start, int const destx, int const desty,
+	std::deque<SDL_Point>& path)
+{
+	// scratch space for the search, rewound when the search returns
+	FrameArena::Scope scratch;
+	auto* arena = &FrameArena::get();
+
+	int const w = tiles[0].size(), h = tiles.size();
+	frame_vector<int> costs(w * h, 0, arena);
+	frame_vector<bool> been(w * h, false, arena);
+	for (int i = 0; i < h; ++i)
 	{
-		for (int j = 0; j < costs[i].size(); ++j)
+		for (int j = 0; j < w; ++j)
 		{
 			if (tiles[i][j].state == TileState::OCCUPIED)
 			{
-				been[i][j] = true;
+				been[i * w + j] = true;
 				continue;
 			}
 
-			int g_cost = abs(j - (int)path_pos.x) + abs(i - (int)path_pos.y);
-			int h_cost = abs(destx - (int)path_pos.x) + abs(destx - (int)path_pos.y);
-			costs[i][j] = g_cost + h_cost;
+			int g_cost = abs(j - (int)start.x) + abs(i - (int)start.y);
+			int h_cost = abs(destx - (int)start.x) + abs(destx - (int)start.y);
+			costs[i * w + j] = g_cost + h_cost;
 		}
 	}
 
-	auto cmp = [&](std::vector<SDL_Point> const& a, std::vector<SDL_Point> const& b) {
-			return costs[a.back().y][a.back().x] - ((tiles[a.back().y][a.back().x].state == TileState::PATH) * 2) <
-				costs[b.back().y][b.back().x] - ((tiles[b.back().y][b.back().x].state == TileState::PATH) * 2);
-		};
+	// every partial path is a node pointing back at the path it extends,
+	//   instead of the queue holding a copy of the whole path
+	// grown as the search goes, most end long before the worst case
+	struct Node
+	{
+		SDL_Point pt;
+		int parent;
+	};
+	frame_vector<Node> nodes(arena);
+
+	auto key = [&](int n) {
+		auto const pt = nodes[n].pt;
+		return costs[pt.y * w + pt.x] - ((tiles[pt.y][pt.x].state == TileState::PATH) * 2);
+	};
+	auto cmp = [&](int a, int b) { return key(a) < key(b); };
+
+	std::priority_queue<int, frame_vector<int>, decltype(cmp)> pq(cmp, frame_vector<int>(arena));
 
-	std::priority_queue<std::vector<SDL_Point>,
-						std::vector<std::vector<SDL_Point>>,
-						decltype(cmp)> pq(cmp);
+	auto push = [&](int x, int y, int parent) {
+		nodes.push_back(Node{ SDL_Point{ x, y }, parent });
+		pq.push((int)nodes.size() - 1);
+	};
 
-	pq.push({ SDL_Point{ (int)path_pos.x, (int)path_pos.y } });
+	push((int)start.x, (int)start.y, -1);
 	while (!pq.empty())
 	{
-		auto points = pq.top();
-		auto const cx = points.back().x, cy = points.back().y;
+		int const n = pq.top();
+		auto const cx = nodes[n].pt.x, cy = nodes[n].pt.y;
 		pq.pop();
 
-		if (been[cy][cx])
+		if (been[cy * w + cx])
 			continue;
 
-		been[cy][cx] = true;
+		been[cy * w + cx] = true;
 		
 		if (cx == destx && cy == desty)
 		{
-			for (auto const& v : points)
-				path.push_back({ v.x, v.y });
+			auto const begin = path.size();
+			for (int i = n; i != -1; i = nodes[i].parent)
+				path.push_back(nodes[i].pt);
+			std::reverse(path.begin() + begin, path.end());
 
-			return;
+			return true;
 		}
 
-		points.push_back(SDL_Point{ cx, cy });
-		if (cx < costs[0].size() - 1)
-		{
-			points.back() = SDL_Point{ cx + 1, cy };
-			pq.push(points);
-		}
+		if (cx < w - 1)
+			push(cx + 1, cy, n);
 		if (cx > 0)
-		{
-			points.back() = SDL_Point{ cx - 1, cy };
-			pq.push(points);
-		}
-		if (cy < costs.size() - 1)
-		{
-			points.back() = SDL_Point{ cx, cy + 1 };
-			pq.push(points);
-		}
+			push(cx - 1, cy, n);
+		if (cy < h - 1)
+			push(cx, cy + 1, n);
 		if (cy > 0)
-		{
-			points.back() = SDL_Point{ cx, cy - 1 };
-			pq.push(points);
-		}
+			push(cx, cy - 1, n);
 	}
 
-	generate_path(tiles);
+	return false;
+}
+
 }
 
-std::random_device Person::dev;
-std::mt19937 Person::eng(Person::dev());
-std::uniform_int_distribution<std::mt19937::result_type> Person::distrx(0, Base::get().TILES_X - 1),
-	Person::distry(0, Base::get().TILES_Y - 1);
\ No newline at end of file
+void Person::generate_path(std::vector<std::vector<Tile>> const& tiles, Rng& rng)
+{
+	PROFILE_SCOPE("Person::generate_path");
+
+	// a destination on a building is never reached, so only free tiles are
+	//   tried, and each search's scratch is rewound before the next
+	for (int tries = 0; tries < MAX_PATH_TRIES; ++tries)
+	{
+		int const destx = rng.range(0, (int)tiles[0].size() - 1);
+		int const desty = rng.range(0, (int)tiles.size() - 1);
+		if ((destx == path_pos.x && desty == path_pos.y) || tiles[desty][destx].state == TileState::OCCUPIED)
+			continue;
+
+		if (search(tiles, path_pos, destx, desty, path))
+			return;
+	}
+
+	// walled in or unlucky, stand still a step and pick again after
+	path.push_back(path_pos);
+}
@@ -0,0 +1,187 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Event
+{
+	char const* name;
+	uint64_t start_ns;
+	uint64_t end_ns;
+};
+
+// relaxed atomics so the exporter can copy a slot while its thread
+//   overwrites it, they compile to plain stores
+struct Slot
+{
+	std::atomic<char const*> name{ nullptr };
+	std::atomic<uint64_t> start_ns{ 0 }, end_ns{ 0 };
+};
+
+// written only by its thread, pushing is a few relaxed stores and a release
+//   of the head
+// the exporter copies behind the head without stopping the thread, then
+//   reads the head again and drops the slots it could have overwritten
+//   meanwhile, like a seqlock with the head as the sequence
+struct Ring
+{
+	static int const SIZE = 1 << 16;
+
+	std::array<Slot, SIZE> events;
+	std::atomic<uint64_t> head{ 0 };
+	int tid;
+};
+
+std::atomic<bool> enabled{ false };
+
+thread_local char const* zone_top = nullptr;
+
+// rings outlive their threads so events can still be exported
+std::mutex rings_mutex;
+std::vector<std::unique_ptr<Ring>> rings;
+
+Ring& thread_ring()
+{
+	thread_local Ring* ring = nullptr;
+	if (ring == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		rings.push_back(std::make_unique<Ring>());
+		ring = rings.back().get();
+		ring->tid = (int)rings.size();
+	}
+
+	return *ring;
+}
+
+std::string escape(char const* str)
+{
+	std::string out;
+	for (; *str; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+			out += '\\';
+		out += *str;
+	}
+
+	return out;
+}
+
+}
+
+namespace prof
+{
+
+void set_enabled(bool const _enabled)
+{
+	enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+bool is_enabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record(char const* name, uint64_t start_ns, uint64_t end_ns)
+{
+	auto& ring = thread_ring();
+
+	uint64_t const head = ring.head.load(std::memory_order_relaxed);
+	auto& slot = ring.events[head % Ring::SIZE];
+
+	// an exporter that copies any of these stores is then sure to see this
+	//   head, which is what tells it the slot was being overwritten
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start_ns.store(start_ns, std::memory_order_relaxed);
+	slot.end_ns.store(end_ns, std::memory_order_relaxed);
+
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+char const* current_zone()
+{
+	return zone_top;
+}
+
+char const* enter_zone(char const* name)
+{
+	char const* parent = zone_top;
+	zone_top = name;
+	return parent;
+}
+
+void leave_zone(char const* parent)
+{
+	zone_top = parent;
+}
+
+bool write_chrome_trace(std::string const& path)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "[error] - could not write trace '" << path << "'\n";
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+	bool first = true;
+	std::vector<Event> events;
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	for (auto const& ring : rings)
+	{
+		uint64_t const head = ring->head.load(std::memory_order_acquire);
+		uint64_t const begin = head > Ring::SIZE ? head - Ring::SIZE : 0;
+
+		events.clear();
+		for (uint64_t i = begin; i < head; ++i)
+		{
+			auto const& slot = ring->events[i % Ring::SIZE];
+			events.push_back(Event{ slot.name.load(std::memory_order_relaxed),
+				slot.start_ns.load(std::memory_order_relaxed), slot.end_ns.load(std::memory_order_relaxed) });
+		}
+
+		// once the head reaches i + SIZE the thread may be writing over event
+		//   i, so only the ones after that are known to be whole
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t const after = ring->head.load(std::memory_order_relaxed);
+		uint64_t const valid = after >= Ring::SIZE ? after - Ring::SIZE + 1 : 0;
+
+		for (uint64_t i = std::max(begin, valid); i < head; ++i)
+		{
+			auto const& e = events[i - begin];
+
+			file << (first ? "" : ",\n")
+				 << "{\"name\": \"" << escape(e.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->tid
+				 << ", \"ts\": " << e.start_ns / 1000.0 << ", \"dur\": " << (e.end_ns - e.start_ns) / 1000.0 << "}";
+			first = false;
+		}
+	}
+
+	file << "\n]}\n";
+	return (bool)file;
+}
+
+}
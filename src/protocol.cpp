@@ -0,0 +1,463 @@
+#include "protocol.hpp"
+#include "save.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+// gold through troph, each one a bit in a STATE's resource mask
+std::size_t const RESOURCES_OFFSET = offsetof(save::Header, gold);
+std::size_t const RESOURCES_SIZE = offsetof(save::Header, tiles_x) - RESOURCES_OFFSET;
+int const RESOURCE_COUNT = RESOURCES_SIZE / sizeof(int32_t);
+
+// which fields of a building a STATE carries
+enum BuildingField : uint8_t
+{
+	FIELD_TYPE = 1,
+	FIELD_LEVEL = 2,
+	FIELD_X = 4,
+	FIELD_Y = 8,
+	FIELD_AMOUNT = 16
+};
+
+int const TILE_BITS = 2;
+int const TILES_PER_BYTE = 8 / TILE_BITS;
+
+template <typename T>
+void put(std::vector<char>& out, T const& v)
+{
+	auto const* p = (char const*)&v;
+	out.insert(out.end(), p, p + sizeof(T));
+}
+
+// 7 bits a byte, low first, the top bit set on all but the last
+void put_varint(std::vector<char>& out, uint64_t v)
+{
+	while (v >= 0x80)
+	{
+		out.push_back((char)(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back((char)v);
+}
+
+// small negative numbers stay small, -1 is 1 and 1 is 2
+uint64_t zigzag(int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+int32_t resource(save::Header const& h, int i)
+{
+	int32_t v;
+	std::memcpy(&v, (char const*)&h + RESOURCES_OFFSET + i * sizeof(int32_t), sizeof(v));
+	return v;
+}
+
+void set_resource(save::Header& h, int i, int32_t v)
+{
+	std::memcpy((char*)&h + RESOURCES_OFFSET + i * sizeof(int32_t), &v, sizeof(v));
+}
+
+uint8_t changed_fields(save::BuildingRecord const& a, save::BuildingRecord const& b)
+{
+	return (a.type != b.type ? FIELD_TYPE : 0)
+		| (a.level != b.level ? FIELD_LEVEL : 0)
+		| (a.x != b.x ? FIELD_X : 0)
+		| (a.y != b.y ? FIELD_Y : 0)
+		| (a.amount != b.amount ? FIELD_AMOUNT : 0);
+}
+
+// reads through a message, every get past the end fails and stays failed
+struct Reader
+{
+	char const* data;
+	std::size_t size;
+	std::size_t off;
+
+	template <typename T>
+	bool get(T& v)
+	{
+		if (off + sizeof(T) > size)
+		{
+			off = size + 1;
+			return false;
+		}
+
+		std::memcpy(&v, data + off, sizeof(T));
+		off += sizeof(T);
+		return true;
+	}
+
+	bool varint(uint64_t& v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64 && off < size; shift += 7)
+		{
+			uint8_t const byte = data[off++];
+			v |= (uint64_t)(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+
+		off = size + 1;
+		return false;
+	}
+
+	// n bytes in place, nullptr past the end
+	char const* bytes(std::size_t n)
+	{
+		if (off + n > size)
+		{
+			off = size + 1;
+			return nullptr;
+		}
+
+		off += n;
+		return data + off - n;
+	}
+
+	bool ok() const { return off <= size; }
+};
+
+std::size_t begin(std::vector<char>& out, net::MsgType type)
+{
+	auto const start = out.size();
+	put(out, uint32_t(0));
+	put(out, type);
+	return start;
+}
+
+void end(std::vector<char>& out, std::size_t start)
+{
+	uint32_t const size = (uint32_t)(out.size() - start);
+	std::memcpy(out.data() + start, &size, 4);
+}
+
+Reader payload(char const* data, std::size_t size)
+{
+	return Reader{ data, size, net::HEADER_SIZE };
+}
+
+}
+
+namespace net
+{
+
+void write_hello(std::vector<char>& out, Hello const& m)
+{
+	auto const start = begin(out, MsgType::HELLO);
+	put(out, m.player);
+	end(out, start);
+}
+
+void write_command(std::vector<char>& out, CommandMsg const& m)
+{
+	auto const start = begin(out, MsgType::COMMAND);
+	put(out, m.seq);
+	put(out, m.command);
+	put(out, m.a);
+	put(out, m.b);
+	put(out, m.c);
+	end(out, start);
+}
+
+void write_result(std::vector<char>& out, Result const& m)
+{
+	auto const start = begin(out, MsgType::RESULT);
+	put(out, m.seq);
+	put(out, m.status);
+	end(out, start);
+}
+
+void write_ack(std::vector<char>& out, Ack const& m)
+{
+	auto const start = begin(out, MsgType::ACK);
+	put(out, m.tick);
+	end(out, start);
+}
+
+void write_welcome(std::vector<char>& out, save::Snapshot const& snap)
+{
+	auto const start = begin(out, MsgType::WELCOME);
+	auto const bytes = save::encode(snap);
+	out.insert(out.end(), bytes.begin(), bytes.end());
+	end(out, start);
+}
+
+bool state_changed(save::Snapshot const& prev, save::Snapshot const& cur)
+{
+	// the layers are copied on write while prev holds them, so the same
+	//   pointer means nothing was written
+	return prev.tiles != cur.tiles || prev.buildings != cur.buildings
+		|| std::memcmp((char const*)&prev.header + RESOURCES_OFFSET, (char const*)&cur.header + RESOURCES_OFFSET, RESOURCES_SIZE) != 0;
+}
+
+void write_state(std::vector<char>& out, uint32_t tick, uint32_t base_tick,
+	save::Snapshot const& base, save::Snapshot const& cur)
+{
+	auto const start = begin(out, MsgType::STATE);
+	put_varint(out, tick);
+	put_varint(out, base_tick);
+
+	uint32_t mask = 0;
+	for (int i = 0; i < RESOURCE_COUNT; ++i)
+	{
+		if (resource(base.header, i) != resource(cur.header, i))
+			mask |= 1u << i;
+	}
+
+	put_varint(out, mask);
+	for (int i = 0; i < RESOURCE_COUNT; ++i)
+	{
+		if (mask & (1u << i))
+			put_varint(out, zigzag((int64_t)resource(cur.header, i) - resource(base.header, i)));
+	}
+
+	auto const& buildings = *cur.buildings;
+	put_varint(out, buildings.size());
+
+	// the layers are copied on write while base holds them, the same
+	//   pointer means nothing in it changed
+	auto const& tiles = *cur.tiles;
+	auto const& old_tiles = *base.tiles;
+	bool const tiles_changed = base.tiles != cur.tiles;
+
+	auto run_end = [&](uint32_t i) {
+		while (i < tiles.size() && tiles[i] != old_tiles[i])
+			i++;
+		return i;
+	};
+
+	uint32_t runs = 0;
+	for (uint32_t i = 0; tiles_changed && i < tiles.size(); ++i)
+	{
+		if (tiles[i] != old_tiles[i])
+		{
+			runs++;
+			i = run_end(i);
+		}
+	}
+
+	put_varint(out, runs);
+	uint32_t prev = 0;
+	for (uint32_t i = 0; runs > 0 && i < tiles.size(); ++i)
+	{
+		if (tiles[i] == old_tiles[i])
+			continue;
+
+		uint32_t const e = run_end(i);
+		put_varint(out, i - prev);
+		put_varint(out, e - i);
+
+		for (uint32_t k = i; k < e; k += TILES_PER_BYTE)
+		{
+			uint8_t packed = 0;
+			for (uint32_t t = k; t < e && t < k + TILES_PER_BYTE; ++t)
+				packed |= (tiles[t] & ((1 << TILE_BITS) - 1)) << ((t - k) * TILE_BITS);
+			out.push_back((char)packed);
+		}
+
+		prev = i = e;
+	}
+
+	// a new building is diffed against an all zero one
+	auto const& old = *base.buildings;
+	auto old_at = [&](uint32_t i) {
+		return i < old.size() ? old[i] : save::BuildingRecord{};
+	};
+
+	bool const buildings_changed = base.buildings != cur.buildings;
+	uint32_t changed = 0;
+	for (uint32_t i = 0; buildings_changed && i < buildings.size(); ++i)
+	{
+		if (changed_fields(old_at(i), buildings[i]) != 0)
+			changed++;
+	}
+
+	put_varint(out, changed);
+	prev = 0;
+	for (uint32_t i = 0; changed > 0 && i < buildings.size(); ++i)
+	{
+		auto const o = old_at(i);
+		auto const& b = buildings[i];
+		uint8_t const fields = changed_fields(o, b);
+		if (fields == 0)
+			continue;
+
+		put_varint(out, i - prev);
+		put(out, fields);
+		if (fields & FIELD_TYPE)
+			put_varint(out, b.type);
+		if (fields & FIELD_LEVEL)
+			put_varint(out, b.level);
+		if (fields & FIELD_X)
+			put_varint(out, zigzag((int64_t)b.x - o.x));
+		if (fields & FIELD_Y)
+			put_varint(out, zigzag((int64_t)b.y - o.y));
+		if (fields & FIELD_AMOUNT)
+			put_varint(out, zigzag((int64_t)b.amount - o.amount));
+
+		prev = i + 1;
+	}
+
+	end(out, start);
+}
+
+long long message_size(char const* data, std::size_t size)
+{
+	if (size < HEADER_SIZE)
+		return 0;
+
+	uint32_t n;
+	std::memcpy(&n, data, 4);
+	if (n < HEADER_SIZE || n > MAX_MESSAGE || (uint8_t)data[4] > (uint8_t)MsgType::ACK)
+		return -1;
+
+	return n <= size ? (long long)n : 0;
+}
+
+MsgType message_type(char const* data)
+{
+	return (MsgType)data[4];
+}
+
+bool read_hello(char const* data, std::size_t size, Hello& m)
+{
+	auto r = payload(data, size);
+	r.get(m.player);
+	return r.ok() && r.off == size;
+}
+
+bool read_command(char const* data, std::size_t size, CommandMsg& m)
+{
+	auto r = payload(data, size);
+	r.get(m.seq);
+	r.get(m.command);
+	r.get(m.a);
+	r.get(m.b);
+	r.get(m.c);
+	return r.ok() && r.off == size && m.command <= Command::ATTACK;
+}
+
+bool read_result(char const* data, std::size_t size, Result& m)
+{
+	auto r = payload(data, size);
+	r.get(m.seq);
+	r.get(m.status);
+	return r.ok() && r.off == size;
+}
+
+bool read_ack(char const* data, std::size_t size, Ack& m)
+{
+	auto r = payload(data, size);
+	r.get(m.tick);
+	return r.ok() && r.off == size;
+}
+
+bool read_welcome(char const* data, std::size_t size, Mirror& out)
+{
+	// copied out first, the save is read through casts and the payload
+	//   isn't aligned for them
+	std::vector<char> bytes(data + HEADER_SIZE, data + size);
+
+	save::View v;
+	if (!save::view(bytes.data(), bytes.size(), v))
+		return false;
+
+	out.tick = 0;
+	out.header = *v.header;
+	out.tiles.assign(v.tiles, v.tiles + (std::size_t)v.header->tiles_x * v.header->tiles_y);
+	out.buildings.assign(v.buildings, v.buildings + v.header->building_count);
+	return true;
+}
+
+bool read_state(char const* data, std::size_t size, Mirror& out)
+{
+	auto r = payload(data, size);
+
+	uint64_t tick, base_tick;
+	if (!r.varint(tick) || !r.varint(base_tick) || base_tick != out.tick)
+		return false;
+
+	uint64_t mask;
+	if (!r.varint(mask) || (mask >> RESOURCE_COUNT) != 0)
+		return false;
+
+	for (int i = 0; i < RESOURCE_COUNT; ++i)
+	{
+		uint64_t diff;
+		if ((mask & (1u << i)) && r.varint(diff))
+			set_resource(out.header, i, (int32_t)(resource(out.header, i) + unzigzag(diff)));
+	}
+
+	// every record takes at least two bytes, more than that can't be real
+	uint64_t building_count;
+	if (!r.varint(building_count) || building_count > MAX_MESSAGE / 2 + out.buildings.size())
+		return false;
+	out.buildings.resize(building_count);
+	out.header.building_count = building_count;
+
+	uint64_t runs;
+	r.varint(runs);
+	uint64_t pos = 0;
+	for (uint64_t i = 0; i < runs && r.ok(); ++i)
+	{
+		uint64_t gap, len;
+		if (!r.varint(gap) || !r.varint(len) || pos + gap + len > out.tiles.size())
+			return false;
+		pos += gap;
+
+		auto const* packed = r.bytes((len + TILES_PER_BYTE - 1) / TILES_PER_BYTE);
+		if (packed == nullptr)
+			return false;
+
+		for (uint64_t t = 0; t < len; ++t)
+			out.tiles[pos + t] = ((uint8_t)packed[t / TILES_PER_BYTE] >> ((t % TILES_PER_BYTE) * TILE_BITS)) & ((1 << TILE_BITS) - 1);
+		pos += len;
+	}
+
+	uint64_t changed;
+	r.varint(changed);
+	uint64_t index = 0;
+	for (uint64_t i = 0; i < changed && r.ok(); ++i)
+	{
+		uint64_t gap;
+		uint8_t fields;
+		if (!r.varint(gap) || !r.get(fields) || index + gap >= building_count)
+			return false;
+		index += gap;
+
+		auto& b = out.buildings[index];
+		uint64_t v;
+		if ((fields & FIELD_TYPE) && r.varint(v))
+			b.type = (uint16_t)v;
+		if ((fields & FIELD_LEVEL) && r.varint(v))
+			b.level = (uint16_t)v;
+		if ((fields & FIELD_X) && r.varint(v))
+			b.x = (int32_t)(b.x + unzigzag(v));
+		if ((fields & FIELD_Y) && r.varint(v))
+			b.y = (int32_t)(b.y + unzigzag(v));
+		if ((fields & FIELD_AMOUNT) && r.varint(v))
+			b.amount = (int32_t)(b.amount + unzigzag(v));
+
+		index++;
+	}
+
+	if (!r.ok() || r.off != size)
+		return false;
+
+	out.tick = tick;
+	return true;
+}
+
+}
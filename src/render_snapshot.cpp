@@ -0,0 +1,32 @@
+#include "render_snapshot.hpp"
+
+#include <atomic>
+
+SnapshotBuffer::SnapshotBuffer()
+	: buffers{}, middle(1), back_index(0), front_index(2), any(false)
+{
+
+}
+
+RenderSnapshot& SnapshotBuffer::back()
+{
+	return buffers[back_index];
+}
+
+void SnapshotBuffer::publish()
+{
+	// release so the renderer sees the whole snapshot, acquire so the sim
+	//   doesn't write into a buffer the renderer still has in flight
+	back_index = middle.exchange(back_index | FRESH, std::memory_order_acq_rel) & 3;
+}
+
+RenderSnapshot const* SnapshotBuffer::acquire()
+{
+	if (middle.load(std::memory_order_relaxed) & FRESH)
+	{
+		front_index = middle.exchange(front_index, std::memory_order_acq_rel) & 3;
+		any = true;
+	}
+
+	return any ? &buffers[front_index] : nullptr;
+}
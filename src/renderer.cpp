@@ -0,0 +1,328 @@
+#include "renderer.hpp"
+#include "render_snapshot.hpp"
+#include "base.hpp"
+#include "building.hpp"
+#include "building_type.hpp"
+#include "screen.hpp"
+#include "sdl2.hpp"
+#include "frame_arena.hpp"
+#include "profiler.hpp"
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include <charconv>
+#include <cmath>
+#include <iterator>
+#include <string>
+
+Renderer& Renderer::get()
+{
+	static Renderer instance;
+	return instance;
+}
+
+Renderer::Renderer()
+	: sprites_loaded(false), sprite_handles{}, sprite_dims{}
+{
+
+}
+
+void Renderer::draw(RenderSnapshot const& s)
+{
+	PROFILE_SCOPE("Renderer::draw");
+
+	draw_hud(s);
+
+	if (s.tutorial)
+		draw_tutorial();
+
+	draw_scene(s);
+	draw_shop(s);
+}
+
+void Renderer::draw_hud(RenderSnapshot const& s)
+{
+	Screen::get().fill(sdl2::clr_black);
+	Screen::get().stroke(sdl2::clr_clear);
+	Screen::get().rect(0, 0, Screen::get().SCREEN_WIDTH, 50);
+
+	Screen::get().fill(sdl2::clr_yellow);
+	Screen::get().rect(0, 50, Screen::get().SCREEN_WIDTH, 5);
+
+	auto label = [](char const* name, int value) {
+		char num[16];
+		auto const end = std::to_chars(num, num + sizeof(num), value).ptr;
+
+		frame_string str(name, &FrameArena::get());
+		str.append(num, end);
+		return str;
+	};
+
+	frame_string str[] = {
+		label("Gold: ", s.gold),
+		label("Wheat: ", s.wheat),
+		label("Wood: ", s.wood),
+		label("Gems: ", s.gems),
+	};
+
+	std::string imgs[] = { "gold.png", "wheat.png", "wood.png", "gems.png" };
+
+	static sdl2::font_ptr ttf_font(TTF_OpenFont(sdl2::str_brygada.c_str(), 24));
+	int text_w, text_h;
+	TTF_SizeText(ttf_font.get(), str[3].c_str(), &text_w, &text_h);
+	int margin = (Screen::get().SCREEN_WIDTH - (Screen::get().SCREEN_WIDTH / 4 * 3 + text_w)) / 2;
+
+	Screen::get().fill(sdl2::clr_yellow);
+	for (int i = 0; i < (int)std::size(str); ++i)
+	{
+		Screen::get().image_align(sdl2::ImageAlign::CENTER_RIGHT);
+		Screen::get().image(imgs[i],(Screen::get().SCREEN_WIDTH / 4 * i) + margin - 10, 4, 40, 40);
+
+		Screen::get().text_size(10);
+		Screen::get().text_font(sdl2::str_brygada);
+		Screen::get().text_align(sdl2::ImageAlign::CENTER_LEFT);
+		Screen::get().text_cached(str[i], 24, (Screen::get().SCREEN_WIDTH / 4 * i) + margin);
+	}
+}
+
+void Renderer::draw_scene(RenderSnapshot const& s)
+{
+	PROFILE_SCOPE("Renderer::draw_scene");
+
+	if (s.placing)
+		draw_grid();
+
+	draw_sprites(s);
+
+	// collect particles fly above everything, so they're drawn in one batch per sprite
+	draw_particles(s);
+
+	draw_bubbles(s);
+
+	if (s.placing)
+		draw_placement_options(s.preview);
+
+	draw_messages(s);
+
+	Screen::get().stroke(sdl2::clr_black);
+	Screen::get().fill(sdl2::clr_white);
+	Screen::get().trig_align(sdl2::TrigAlign::CENTER);
+	Screen::get().trig(200, 200, 250, 150, 250, 250, sdl2::TrigQuad::MIDDLE);
+}
+
+void Renderer::draw_shop(RenderSnapshot const& s)
+{
+	const int shop_h = Screen::get().SCREEN_HEIGHT - 300;
+
+	switch ((Base::ShopState)s.shop_state)
+	{
+	case Base::ShopState::HIDDEN: {
+		if (!s.placing)
+		{
+			Screen::get().fill(sdl2::clr_white);
+			Screen::get().text_font(sdl2::str_brygada);
+			Screen::get().text_size(45);
+			Screen::get().text_align(sdl2::TextAlign::CENTER_RIGHT);
+			Screen::get().text("BUILD", Screen::get().SCREEN_WIDTH - 20, Screen::get().SCREEN_HEIGHT - 65);
+		}
+
+		break;
+	}
+	case Base::ShopState::APPEARING:
+	case Base::ShopState::DISAPPEARING: {
+		Screen::get().fill(sdl2::clr_black);
+		Screen::get().stroke(sdl2::clr_clear);
+		Screen::get().rect(0, s.shop_y, Screen::get().SCREEN_WIDTH, Screen::get().SCREEN_HEIGHT - shop_h);
+
+		break;
+	}
+	case Base::ShopState::VISIBLE: {
+		Screen::get().fill(sdl2::clr_black);
+		Screen::get().stroke(sdl2::clr_clear);
+		Screen::get().rect(0, shop_h, Screen::get().SCREEN_WIDTH, Screen::get().SCREEN_HEIGHT - shop_h);
+
+		Screen::get().fill(sdl2::clr_white);
+		Screen::get().text("CLOSE", sdl2::str_brygada, 35,
+			Screen::get().SCREEN_WIDTH - 15, shop_h - 40, sdl2::TextAlign::CENTER_RIGHT);
+
+		Screen::get().image_align(sdl2::ImageAlign::CENTER);
+		for (int i = 0; i < BuildingCatalog::get().size(); ++i)
+			Screen::get().image(BuildingCatalog::get()[i].img, Base::shop_dim(i));
+
+		break;
+	}
+	}
+}
+
+void Renderer::draw_grid()
+{
+	int const sides = 9;
+	int const w = 70;
+	int const h = 50;
+
+	int const x_base = Screen::get().SCREEN_WIDTH / 2;
+	int const y_base = 60;
+
+	for (int i = 0; i < sides + 1; ++i)
+	{
+		int const x0_off = i * (w / 2);
+		int const y0_off = i * (h / 2);
+		int const x1_off = ((w / 2) * sides) - (i * w / 2);
+		int const y1_off = ((h / 2) * sides) + (i * h / 2);
+
+		Screen::get().stroke(sdl2::clr_white);
+
+		Screen::get().line(
+			x_base - x0_off, y_base + y0_off,
+			x_base + x1_off, y_base + y1_off);
+
+		Screen::get().line(
+			x_base + x0_off, y_base + y0_off,
+			x_base - x1_off, y_base + y1_off);
+	}
+}
+
+void Renderer::draw_sprites(RenderSnapshot const& s)
+{
+	PROFILE_SCOPE("Renderer::draw_sprites");
+
+	for (auto const& sprite : s.scene)
+	{
+		switch (sprite.kind)
+		{
+		case DrawKind::BUILDING: {
+			Screen::get().image_align(sdl2::ImageAlign::CENTER);
+			Screen::get().image(BuildingCatalog::get()[sprite.type].img,
+				Building::dim_of(sprite.type, sprite.x, sprite.y), sprite.flag ? 200 : 255);
+			break;
+		}
+		case DrawKind::PREVIEW: {
+			auto const d = Building::dim_of(sprite.type, sprite.x, sprite.y);
+
+			// the backdrop covers whole tiles, an even number of them each way
+			int rect_w = std::ceil(d.w / 20.0);
+			rect_w = (rect_w + (rect_w % 2)) * 20;
+
+			int rect_h = std::ceil(d.h / 20.0);
+			rect_h = (rect_h + (rect_h % 2)) * 20;
+
+			Screen::get().fill(sprite.flag ? sdl2::clr_green : sdl2::clr_red);
+			Screen::get().stroke(sdl2::clr_clear);
+			Screen::get().rhom(d.x, d.y, rect_w, rect_h);
+
+			Screen::get().image_align(sdl2::ImageAlign::CENTER);
+			Screen::get().image(BuildingCatalog::get()[sprite.type].img, d);
+			break;
+		}
+		case DrawKind::FARMER: {
+			Screen::get().image_align(sdl2::ImageAlign::CENTER);
+			Screen::get().image("farmer.png", sprite.x, sprite.y, 100, 60);
+			break;
+		}
+		}
+	}
+}
+
+void Renderer::draw_particles(RenderSnapshot const& s)
+{
+	PROFILE_SCOPE("Renderer::draw_particles");
+
+	if (s.particles.empty())
+		return;
+
+	if (!sprites_loaded)
+	{
+		for (int i = 0; i < PROD_TYPES; ++i)
+		{
+			// make sure width and height scale together
+			sprite_handles[i] = Screen::get().image_handle(prod_img((ProdType)i));
+			auto p = Screen::get().get_img_dim(sprite_handles[i]);
+			sprite_dims[i] = { 45, p.second / (p.first / 45) };
+		}
+
+		sprites_loaded = true;
+	}
+
+	for (int t = 0; t < PROD_TYPES; ++t)
+	{
+		int const w = sprite_dims[t].x, h = sprite_dims[t].y;
+
+		int n = 0;
+		for (auto const& p : s.particles)
+		{
+			if ((int)p.sprite != t)
+				continue;
+
+			batch_rects[n] = SDL_FRect{ (float)(int)p.x - (w / 2), (float)(int)p.y - (h / 2), (float)w, (float)h };
+			batch_alphas[n] = (uint8_t)p.alpha;
+			n++;
+		}
+
+		if (n > 0)
+			Screen::get().image_batch(sprite_handles[t], batch_rects.data(), batch_alphas.data(), n);
+	}
+}
+
+void Renderer::draw_bubbles(RenderSnapshot const& s)
+{
+	for (auto const& bubble : s.bubbles)
+	{
+		auto const d = Building::dim_of(bubble.type, bubble.x, bubble.y);
+		int side = 70;
+		int item_y = d.y - (d.h / 2) - (side / 2);
+
+		Screen::get().fill(sdl2::clr_gray);
+		Screen::get().stroke(sdl2::clr_black);
+		Screen::get().rect_align(sdl2::RectAlign::CENTER);
+		Screen::get().rect(d.x, item_y, side, side, 15);
+
+		std::string const img = prod_img(BuildingCatalog::get()[bubble.type].prod_type);
+		sdl2::Dimension img_dim{ d.x, item_y, 50, 0 };
+
+		auto p = Screen::get().get_img_dim(img);
+		img_dim.h = p.second / (p.first / img_dim.w);
+		Screen::get().image_align(sdl2::ImageAlign::CENTER);
+		Screen::get().image(img, img_dim);
+	}
+}
+
+void Renderer::draw_placement_options(RenderSnapshot::Sprite const& preview)
+{
+	auto const d = Building::dim_of(preview.type, preview.x, preview.y);
+	int base = d.y - (d.h / 2) - 30;
+
+	Screen::get().image_align(sdl2::ImageAlign::CENTER);
+	Screen::get().image("checkmark.png", d.x - 40, base, 40, 40);
+	Screen::get().image("x.png",		 d.x + 40, base, 40, 40);
+}
+
+void Renderer::draw_messages(RenderSnapshot const& s)
+{
+	for (auto const& msg : s.messages)
+	{
+		Screen::get().fill(255, 255, 255, (uint8_t)(255 * msg.alpha));
+		Screen::get().text("Not enough resources", sdl2::str_brygada, 20,
+			msg.x, msg.y, sdl2::TextAlign::CENTER);
+	}
+}
+
+void Renderer::draw_tutorial()
+{
+	Screen::get().fill(sdl2::clr_black);
+	Screen::get().stroke(sdl2::clr_white);
+	Screen::get().rect(100, 80, 850, 200);
+
+	Screen::get().fill(sdl2::clr_yellow);
+	Screen::get().text_font(sdl2::str_brygada);
+	Screen::get().text_align(sdl2::TextAlign::CENTER_LEFT);
+
+	Screen::get().text_size(24);
+	Screen::get().text("Welcome to Nighthawk: Kingdoms!", 120, 100);
+
+	Screen::get().text_size(24);
+	Screen::get().text("Here you can build your own kingdom and collect resources!", 120, 140);
+
+	Screen::get().text_size(24);
+	Screen::get().text("Click the shop button to place your first building, then you are good to go!", 120, 180);
+}
@@ -0,0 +1,61 @@
+#include "rng.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+
+// expands one seed into well mixed state, as recommended for xoshiro
+uint64_t splitmix64(uint64_t& x)
+{
+	uint64_t z = (x += 0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+}
+
+Rng::Rng(uint64_t const _seed)
+{
+	seed(_seed);
+}
+
+void Rng::seed(uint64_t const seed)
+{
+	uint64_t x = seed;
+	for (auto& word : s)
+		word = splitmix64(x);
+}
+
+void Rng::fill_range(int* out, std::size_t n, int const lb, int const ub)
+{
+	for (std::size_t i = 0; i < n; ++i)
+		out[i] = range(lb, ub);
+}
+
+void Rng::fill_uniform(float* out, std::size_t n, float const lb, float const ub)
+{
+	float const scale = 0x1.0p-24f * (ub - lb);
+	for (std::size_t i = 0; i < n; ++i)
+		out[i] = lb + (float)(next() >> 40) * scale;
+}
+
+RngStreams::RngStreams(uint64_t const _seed)
+{
+	seed(_seed);
+}
+
+void RngStreams::seed(uint64_t const seed)
+{
+	// each stream gets its own seed drawn from the session seed
+	uint64_t x = seed;
+	for (auto& stream : streams)
+		stream.seed(splitmix64(x));
+}
+
+Rng& RngStreams::operator[](RngStream const stream)
+{
+	return streams[(int)stream];
+}
@@ -0,0 +1,265 @@
+#include "save.hpp"
+#include "base.hpp"
+#include "building_type.hpp"
+#include "tile.hpp"
+#include "mapped_file.hpp"
+#include "profiler.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::endian::native == std::endian::little, "saves are read in place, big endian needs byte swapping");
+
+namespace
+{
+
+char const MAGIC[4] = { 'N', 'K', 'S', 'V' };
+char const ZMAGIC[4] = { 'N', 'K', 'S', 'Z' };
+
+std::size_t align4(std::size_t n)
+{
+	return (n + 3) & ~(std::size_t)3;
+}
+
+}
+
+namespace save
+{
+
+std::vector<char> encode(Snapshot const& snap)
+{
+	PROFILE_SCOPE("save::encode");
+
+	auto const& tiles = *snap.tiles;
+	auto const& buildings = *snap.buildings;
+
+	Header header = snap.header;
+	std::memcpy(header.magic, MAGIC, 4);
+	header.version = VERSION;
+	header.building_count = (uint32_t)buildings.size();
+	header.tiles_offset = sizeof(Header);
+	header.buildings_offset = (uint32_t)align4(sizeof(Header) + tiles.size());
+
+	std::vector<char> bytes(header.buildings_offset + buildings.size() * sizeof(BuildingRecord));
+	std::memcpy(bytes.data(), &header, sizeof(Header));
+	std::memcpy(bytes.data() + header.tiles_offset, tiles.data(), tiles.size());
+	if (!buildings.empty())
+		std::memcpy(bytes.data() + header.buildings_offset, buildings.data(), buildings.size() * sizeof(BuildingRecord));
+
+	return bytes;
+}
+
+bool view(char const* data, std::size_t size, View& out)
+{
+	if (size < sizeof(Header))
+		return false;
+
+	auto const* header = (Header const*)data;
+	if (std::memcmp(header->magic, MAGIC, 4) != 0 || header->version != VERSION)
+		return false;
+	if (header->tiles_x <= 0 || header->tiles_y <= 0)
+		return false;
+
+	std::size_t const tiles = (std::size_t)header->tiles_x * header->tiles_y;
+	std::size_t const buildings = (std::size_t)header->building_count * sizeof(BuildingRecord);
+	if (header->tiles_offset < sizeof(Header) || header->tiles_offset + tiles > header->buildings_offset
+		|| header->buildings_offset % 4 != 0 || header->buildings_offset + buildings > size)
+		return false;
+
+	// everything that's later cast to an enum or used as an index, checked
+	//   once here so loading and matchmaking can trust the mapping
+	auto const* tile_states = (uint8_t const*)(data + header->tiles_offset);
+	for (std::size_t i = 0; i < tiles; ++i)
+	{
+		if (tile_states[i] > (uint8_t)TileState::OCCUPIED)
+			return false;
+	}
+
+	auto const* records = (BuildingRecord const*)(data + header->buildings_offset);
+	for (uint32_t i = 0; i < header->building_count; ++i)
+	{
+		if (records[i].type >= BuildingCatalog::get().size())
+			return false;
+	}
+
+	out.header = header;
+	out.tiles = tile_states;
+	out.buildings = records;
+	return true;
+}
+
+std::vector<char> compress(std::vector<char> const& bytes)
+{
+	PROFILE_SCOPE("save::compress");
+
+	std::vector<char> out(8);
+	std::memcpy(out.data(), ZMAGIC, 4);
+	uint32_t const size = (uint32_t)bytes.size();
+	std::memcpy(out.data() + 4, &size, 4);
+	out.reserve(8 + bytes.size() / 4);
+
+	// 0..127 is n + 1 literal bytes, -1..-127 repeats the next byte 1 - n times
+	std::size_t i = 0;
+	while (i < bytes.size())
+	{
+		std::size_t run = 1;
+		while (i + run < bytes.size() && run < 128 && bytes[i + run] == bytes[i])
+			run++;
+
+		if (run >= 3)
+		{
+			out.push_back((char)(1 - (int)run));
+			out.push_back(bytes[i]);
+			i += run;
+			continue;
+		}
+
+		// literals until the next run of 3
+		std::size_t lit = 0;
+		while (i + lit < bytes.size() && lit < 128
+			&& !(i + lit + 2 < bytes.size() && bytes[i + lit] == bytes[i + lit + 1] && bytes[i + lit] == bytes[i + lit + 2]))
+			lit++;
+
+		out.push_back((char)(lit - 1));
+		out.insert(out.end(), bytes.begin() + i, bytes.begin() + i + lit);
+		i += lit;
+	}
+
+	return out;
+}
+
+bool decompress(char const* data, std::size_t size, std::vector<char>& out)
+{
+	PROFILE_SCOPE("save::decompress");
+
+	if (size < 8 || std::memcmp(data, ZMAGIC, 4) != 0)
+		return false;
+
+	uint32_t raw_size;
+	std::memcpy(&raw_size, data + 4, 4);
+
+	out.clear();
+	out.reserve(raw_size);
+
+	std::size_t i = 8;
+	while (i < size && out.size() < raw_size)
+	{
+		int const n = (signed char)data[i++];
+		if (n >= 0)
+		{
+			if (i + n + 1 > size)
+				return false;
+			out.insert(out.end(), data + i, data + i + n + 1);
+			i += n + 1;
+		}
+		else if (n != -128)
+		{
+			if (i >= size)
+				return false;
+			out.insert(out.end(), 1 - n, data[i++]);
+		}
+	}
+
+	return out.size() == raw_size;
+}
+
+bool write_file(std::string const& path, char const* data, std::size_t size, bool const sync)
+{
+	std::string const tmp = path + ".tmp";
+
+	FILE* file = std::fopen(tmp.c_str(), "wb");
+	if (file == nullptr)
+	{
+		std::cout << "[error] - could not write '" << tmp << "'\n";
+		return false;
+	}
+
+	bool ok = std::fwrite(data, 1, size, file) == size && std::fflush(file) == 0;
+#ifdef _WIN32
+	ok = ok && (!sync || _commit(_fileno(file)) == 0);
+#else
+	ok = ok && (!sync || fsync(fileno(file)) == 0);
+#endif
+	ok = std::fclose(file) == 0 && ok;
+
+#ifdef _WIN32
+	ok = ok && MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+
+	// the rename is only durable once the directory is, otherwise a power
+	//   cut can bring the old file back after later writes that rely on it
+	if (ok && sync)
+	{
+		std::string const dir = std::filesystem::path(path).parent_path().string();
+		int const fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+		ok = fd >= 0 && fsync(fd) == 0;
+		if (fd >= 0)
+			::close(fd);
+	}
+#endif
+
+	if (!ok)
+	{
+		std::cout << "[error] - could not save '" << path << "'\n";
+		std::remove(tmp.c_str());
+	}
+
+	return ok;
+}
+
+bool save(Base const& base, std::string const& path)
+{
+	auto const bytes = encode(base.snapshot());
+	return write_file(path, bytes.data(), bytes.size());
+}
+
+bool load(Base& base, std::string const& path, uint64_t* journal_seq)
+{
+	PROFILE_SCOPE("save::load");
+
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+
+	// compressed saves are inflated first, plain ones are read in place
+	std::vector<char> inflated;
+	char const* data = file.data();
+	std::size_t size = file.size();
+	if (decompress(data, size, inflated))
+	{
+		data = inflated.data();
+		size = inflated.size();
+	}
+
+	View v;
+	if (!view(data, size, v))
+	{
+		std::cout << "[error] - '" << path << "' is not a save from this version\n";
+		return false;
+	}
+
+	base.restore(v);
+	if (journal_seq)
+		*journal_seq = v.header->journal_seq;
+
+	return true;
+}
+
+}
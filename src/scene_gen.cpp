@@ -0,0 +1,115 @@
+#include "scene_gen.hpp"
+#include "base.hpp"
+#include "building_type.hpp"
+#include "particles.hpp"
+#include "screen.hpp"
+#include "rng.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+bool parse_scene_config(std::string const& str, SceneConfig& config)
+{
+	std::istringstream ss(str);
+	for (std::string item; std::getline(ss, item, ',');)
+	{
+		auto const eq = item.find('=');
+		if (eq == std::string::npos)
+		{
+			std::cout << "[error] - bad scene option '" << item << "'\n";
+			return false;
+		}
+
+		auto const key = item.substr(0, eq);
+		auto const val = std::strtoll(item.c_str() + eq + 1, nullptr, 10);
+
+		if (key == "buildings")
+			config.buildings = (int)val;
+		else if (key == "villagers")
+			config.villagers = (int)val;
+		else if (key == "particles")
+			config.particles = (int)val;
+		else if (key == "w")
+			config.tiles_x = (int)val;
+		else if (key == "h")
+			config.tiles_y = (int)val;
+		else if (key == "seed")
+			config.seed = (uint64_t)val;
+		else
+		{
+			std::cout << "[error] - unknown scene option '" << key << "'\n";
+			return false;
+		}
+	}
+
+	if (config.tiles_x <= 0 || config.tiles_y <= 0)
+	{
+		std::cout << "[error] - scene needs at least one tile\n";
+		return false;
+	}
+
+	return true;
+}
+
+StressScene::StressScene(SceneConfig const& _config, Base& _base)
+	: config(_config), base(_base), rng(_config.seed), placed(0)
+{
+
+}
+
+void StressScene::generate()
+{
+	rng.seed(config.seed);
+	base.reset(config.tiles_x, config.tiles_y);
+	base.seed(config.seed);
+
+	// positions are in screen space like a mouse drag, snapped to the grid
+	int const types = BuildingCatalog::get().size();
+	int const max_x = 5 + config.tiles_x * 20, max_y = 60 + config.tiles_y * 20;
+
+	placed = 0;
+	for (int tries = 0; placed < config.buildings && tries < config.buildings * 20; ++tries)
+	{
+		int const type = rng.range(0, types - 1);
+		placed += base.add_building(type, rng.range(5, max_x - 1), rng.range(60, max_y - 1));
+	}
+
+	int villagers = 0;
+	for (int tries = 0; villagers < config.villagers && tries < config.villagers * 20; ++tries)
+		villagers += base.add_farmer(rng.range(0, config.tiles_x - 1), rng.range(0, config.tiles_y - 1));
+
+	if (placed < config.buildings || villagers < config.villagers)
+	{
+		std::cout << "[warning] - scene only fit " << placed << " buildings and "
+			<< villagers << " villagers\n";
+	}
+
+	update();
+}
+
+void StressScene::update()
+{
+	// particles are only drawn, a headless base has none
+	if (base.headless)
+		return;
+
+	int const missing = config.particles - Particles::get().size();
+	if (missing <= 0)
+		return;
+
+	// spread over the visible part of the base
+	int const w = std::min(config.tiles_x * 20, Screen::get().SCREEN_WIDTH);
+	int const h = std::min(config.tiles_y * 20, Screen::get().SCREEN_HEIGHT - 60);
+
+	for (int left = missing; left > 0; left -= 10)
+		Particles::get().spawn(rng, ProdType::GOLD, 5 + rng.range(0, w - 1), 60 + rng.range(0, h - 1), std::min(left, 10));
+}
+
+int StressScene::placed_buildings() const
+{
+	return placed;
+}
@@ -1,5 +1,7 @@
 #include "screen.hpp"
 #include "sdl2.hpp"
+#include "profiler.hpp"
+#include "frame_arena.hpp"
 
 #include <SDL.h>
 #include <SDL_ttf.h>
@@ -9,6 +11,7 @@
 #include <cassert>
 #include <stdexcept>
 #include <algorithm>
+#include <cmath>
 #include <map>
 
 Screen& Screen::get()
@@ -21,7 +24,9 @@ Screen::Screen()
 	: SCREEN_WIDTH(1170), SCREEN_HEIGHT(525)
 	, fill_clr(sdl2::clr_clear), stroke_clr(sdl2::clr_clear)
 	, stroke_weight(1)
-	, m_line_mode(sdl2::LineMode::ANTIALIASING) {}
+	, m_line_mode(sdl2::LineMode::ANTIALIASING)
+	, stats{}, prev_stats{}, window_sum{}, window_head(0), window_count(0)
+	, stats_paused(false), bound_texture(nullptr), draw_clr{}, draw_clr_valid(false) {}
 
 void Screen::set_window()
 {
@@ -49,9 +54,59 @@ void Screen::set_window()
 	SDL_SetRenderDrawBlendMode(renderer.get(), SDL_BLENDMODE_BLEND);
 }
 
+void Screen::set_headless()
+{
+	headless_surface.reset(SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32));
+
+	if (!headless_surface)
+	{
+		std::cout << "error - failed to create surface\n    " << SDL_GetError();
+		return;
+	}
+
+	renderer.reset(SDL_CreateSoftwareRenderer(headless_surface.get()));
+
+	if (!renderer)
+	{
+		std::cout << "error - failed to create renderer\n    " << SDL_GetError();
+		return;
+	}
+
+	SDL_SetRenderDrawBlendMode(renderer.get(), SDL_BLENDMODE_BLEND);
+}
+
 void Screen::update()
 {
+	PROFILE_SCOPE("Screen::update");
+
 	SDL_RenderPresent(renderer.get());
+
+	window_sum -= stats_window[window_head];
+	window_sum += stats;
+	stats_window[window_head] = stats;
+	window_head = (window_head + 1) % STATS_WINDOW;
+	window_count = std::min(window_count + 1, STATS_WINDOW);
+
+	prev_stats = stats;
+	stats = Stats{};
+	bound_texture = nullptr;
+
+	FrameArena::get().reset();
+}
+
+Screen::Stats const& Screen::last_frame_stats() const
+{
+	return prev_stats;
+}
+
+double Screen::average_stats(int64_t Stats::* field) const
+{
+	return window_count == 0 ? 0 : (double)(window_sum.*field) / window_count;
+}
+
+void Screen::pause_stats(bool const paused)
+{
+	stats_paused = paused;
 }
 
 void Screen::clear()
@@ -105,15 +160,19 @@ void Screen::trig(int x0, int y0, int x1, int y1, int x2, int y2,
 	// fill
 
 	auto plot = [&](int x, int y) {
-		SDL_SetRenderDrawColor(renderer.get(), fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a);
-		SDL_RenderDrawPoint(renderer.get(), x, y);
+		render_color(fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a);
+		render_point(x, y);
 	};
 
 	auto interpolate = [](int x0, int y0, int x1, int y1) {
+		frame_vector<int> vals(&FrameArena::get());
 		if (x0 == x1)
-			return std::vector<int>{ y0 };
-		
-		std::vector<int> vals;
+		{
+			vals.push_back(y0);
+			return vals;
+		}
+
+		vals.reserve(x1 - x0 + 1);
 		double a = 1.0 * (y1 - y0) / (x1 - x0);
 		double d = y0;
 		for (int i = x0; i <= x1; ++i)
@@ -147,21 +206,12 @@ void Screen::trig(int x0, int y0, int x1, int y1, int x2, int y2,
 
 	x01.pop_back();
 
-	auto x012 = x01;
+	auto& x012 = x01;
 	x012.insert(x012.end(), x12.begin(), x12.end());
 
-	std::vector<int> x_left, x_right;
 	int m = x012.size() / 2;
-	if (x02[m] < x012[m])
-	{
-		x_left = x02;
-		x_right = x012;
-	}
-	else
-	{
-		x_left = x012;
-		x_right = x02;
-	}
+	auto const& x_left = x02[m] < x012[m] ? x02 : x012;
+	auto const& x_right = x02[m] < x012[m] ? x012 : x02;
 
 	auto tmp_stroke = stroke_clr;
 
@@ -180,11 +230,11 @@ void Screen::rect(int x, int y, int w, int h)
 {
 	SDL_Rect rect = rect_align_coords(m_rect_align, x, y, w, h);
 
-	SDL_SetRenderDrawColor(renderer.get(), fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a);
-	SDL_RenderFillRect(renderer.get(), &rect);
+	render_color(fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a);
+	render_rect(rect, true);
 
-	SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a);
-	SDL_RenderDrawRect(renderer.get(), &rect);
+	render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a);
+	render_rect(rect, false);
 }
 
 void Screen::rect(int x, int y, int w, int h, int r)
@@ -280,53 +330,109 @@ void Screen::circle(int const x, int const y, int const r,
 			double dy = r - h;
 			double d = std::sqrt((dx * dx) + (dy * dy)) - r;
 			if (d < -1.5)
-				SDL_SetRenderDrawColor(renderer.get(), fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a);
+				render_color(fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a);
 			else if (d <= -1)
-				SDL_SetRenderDrawColor(renderer.get(), fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a / 3);
+				render_color(fill_clr.r, fill_clr.g, fill_clr.b, fill_clr.a / 3);
 			else if (d <= -0.5)
-				SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a / 2);
+				render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a / 2);
 			else if (d <= 0)
-				SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a);
+				render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a);
 			else if (d <= stroke_weight - 1)
-				SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a / 2);
+				render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a / 2);
 			else if (d <= stroke_weight)
-				SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a / 3);
+				render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a / 3);
 			else
 				continue;
 
-			SDL_RenderDrawPoint(renderer.get(), x + dx, y + dy);
+			render_point(x + dx, y + dy);
 		}
 	}
 }
 
 void Screen::text(std::string const& text, int x, int y)
-{ 
+{
+	PROFILE_SCOPE("Screen::text");
+
 	sdl2::font_ptr ttf_font(TTF_OpenFont(m_text_font.c_str(), m_text_size));
 	sdl2::surface_ptr text_surface(TTF_RenderText_Solid(ttf_font.get(), text.c_str(), fill_clr));
-	sdl2::texture_ptr text_texture(SDL_CreateTextureFromSurface(renderer.get(), text_surface.get()));
+	count(&Stats::text_rasterizations);
+	sdl2::texture_ptr text_texture(upload(text_surface.get()));
 
 	SDL_Rect text_rect = rect_align_coords(m_text_align, x, y);
 	TTF_SizeText(ttf_font.get(), text.c_str(), &text_rect.w, &text_rect.h);
 	
-	SDL_RenderCopy(renderer.get(), text_texture.get(), NULL, &text_rect);
+	render_copy(text_texture.get(), text_rect);
 }
 
 void Screen::text(sdl2::Text const& text)
 {
+	PROFILE_SCOPE("Screen::text");
+
 	fill(text.clr);
-	text_font(text.font);
-	text_size(45);
-	text_align(text.align);
+	this->text(text.text, text.font, text.size, text.dim.x, text.dim.y, text.align);
+}
 
-	sdl2::font_ptr ttf_font(TTF_OpenFont(m_text_font.c_str(), m_text_size));
-	sdl2::surface_ptr text_surface(TTF_RenderText_Solid(ttf_font.get(), text.txt.c_str(), fill_clr));
-	sdl2::texture_ptr text_texture(SDL_CreateTextureFromSurface(renderer.get(), text_surface.get()));
+void Screen::text(std::string const& text, std::string const& font, int size, int x, int y, sdl2::TextAlign const& align)
+{
+	text_font(font);
+	text_size(size);
+	text_align(align);
+	this->text(text, x, y);
+}
+
+void Screen::text_cached(std::string_view text, int x, int y)
+{
+	auto& set = glyph_set(m_text_font, m_text_size);
+
+	auto index = [](char c) { return c >= 32 && c < 127 ? c - 32 : '?' - 32; };
 
-	SDL_Rect text_rect = rect_align_coords(text.align, text.x, text.y);
-	TTF_SizeText(ttf_font.get(), text.txt.c_str(), &text_rect.w, &text_rect.h);
+	int w = 0;
+	for (char c : text)
+		w += set.w[index(c)];
 
-	SDL_RenderCopy(renderer.get(), text_texture.get(), NULL, &text_rect);
+	SDL_Rect rect = rect_align_coords(m_text_align, x, y, w, set.h);
+	for (char c : text)
+	{
+		auto const& glyph = set.glyphs[index(c)];
+		rect.w = set.w[index(c)];
 
+		if (glyph)
+		{
+			render_texture_mod(glyph.get(), fill_clr);
+			render_copy(glyph.get(), rect);
+		}
+
+		rect.x += rect.w;
+	}
+}
+
+Screen::GlyphSet& Screen::glyph_set(std::string const& font, int size)
+{
+	for (auto& set : glyph_sets)
+	{
+		if (set->size == size && set->font == font)
+			return *set;
+	}
+
+	auto set = std::make_unique<GlyphSet>();
+	set->font = font;
+	set->size = size;
+
+	sdl2::font_ptr ttf_font(TTF_OpenFont(font.c_str(), size));
+	set->h = TTF_FontHeight(ttf_font.get());
+
+	// white so the colour can be set per draw with a colour mod
+	for (int i = 0; i < 95; ++i)
+	{
+		sdl2::surface_ptr surface(TTF_RenderGlyph_Blended(ttf_font.get(), (Uint16)(i + 32), sdl2::clr_white));
+		count(&Stats::text_rasterizations);
+		set->w[i] = surface ? surface->w : 0;
+		if (surface)
+			set->glyphs[i].reset(upload(surface.get()));
+	}
+
+	glyph_sets.push_back(std::move(set));
+	return *glyph_sets.back();
 }
 
 std::pair<int, int> Screen::get_img_dim(std::string const& img)
@@ -338,7 +444,7 @@ std::pair<int, int> Screen::get_img_dim(std::string const& img)
 		if (image == nullptr)
 			std::cout << "[error] - image '" + img + "' could not load\n";
 
-		images[img] = sdl2::texture_ptr(SDL_CreateTextureFromSurface(renderer.get(), image.get()));
+		images[img] = sdl2::texture_ptr(upload(image.get()));
 	}
 	
 	SDL_Point size;
@@ -349,19 +455,21 @@ std::pair<int, int> Screen::get_img_dim(std::string const& img)
 
 void Screen::image(std::string const& img, int x, int y, int w, int h, int alpha)
 {
+	PROFILE_SCOPE("Screen::image");
+
 	if (images.find(img) == images.end())
 	{
 		sdl2::surface_ptr image(IMG_Load(std::string("../assets/" + img).c_str()));
 		if (image == nullptr)
 			std::cout << "[fatal error] - image '" + img + "' could not load\n";
 
-		images[img] = sdl2::texture_ptr(SDL_CreateTextureFromSurface(renderer.get(), image.get()));
+		images[img] = sdl2::texture_ptr(upload(image.get()));
 	}
 
 	SDL_Rect rect = rect_align_coords(m_image_align, x, y, w, h);
 
-	SDL_SetTextureAlphaMod(images[img].get(), alpha);
-	SDL_RenderCopy(renderer.get(), images[img].get(), NULL, &rect);
+	render_texture_mod(images[img].get(), SDL_Color{ 255, 255, 255, (Uint8)alpha });
+	render_copy(images[img].get(), rect);
 }
 
 void Screen::image(std::string const& img, sdl2::Dimension const& dim, int alpha)
@@ -369,6 +477,62 @@ void Screen::image(std::string const& img, sdl2::Dimension const& dim, int alpha
 	image(img, dim.x, dim.y, dim.w, dim.h, alpha);
 }
 
+int Screen::image_handle(std::string const& img)
+{
+	auto const it = image_handles.find(img);
+	if (it != image_handles.end())
+		return it->second;
+
+	get_img_dim(img); // loads the texture
+
+	handle_textures.push_back(images[img].get());
+	image_handles[img] = (int)handle_textures.size() - 1;
+
+	return image_handles[img];
+}
+
+std::pair<int, int> Screen::get_img_dim(int handle)
+{
+	SDL_Point size;
+	SDL_QueryTexture(handle_textures[handle], NULL, NULL, &size.x, &size.y);
+
+	return { size.x, size.y };
+}
+
+void Screen::image_batch(int handle, SDL_FRect const* rects, uint8_t const* alphas, int n)
+{
+	PROFILE_SCOPE("Screen::image_batch");
+
+	batch_vertices.clear();
+	batch_indices.clear();
+
+	for (int i = 0; i < n; ++i)
+	{
+		auto const& r = rects[i];
+		SDL_Color const clr{ 255, 255, 255, alphas[i] };
+		int const v = (int)batch_vertices.size();
+
+		batch_vertices.push_back({ { r.x,		r.y		  }, clr, { 0, 0 } });
+		batch_vertices.push_back({ { r.x + r.w, r.y		  }, clr, { 1, 0 } });
+		batch_vertices.push_back({ { r.x + r.w, r.y + r.h }, clr, { 1, 1 } });
+		batch_vertices.push_back({ { r.x,		r.y + r.h }, clr, { 0, 1 } });
+
+		for (int idx : { 0, 1, 2, 0, 2, 3 })
+			batch_indices.push_back(v + idx);
+	}
+
+	if (n > 0)
+	{
+		count_texture(handle_textures[handle]);
+		count(&Stats::geometry);
+		count(&Stats::draw_calls);
+
+		SDL_RenderGeometry(renderer.get(), handle_textures[handle],
+			batch_vertices.data(), (int)batch_vertices.size(),
+			batch_indices.data(), (int)batch_indices.size());
+	}
+}
+
 void Screen::line_mode(sdl2::LineMode const& mode)
 {
 	m_line_mode = mode;
@@ -404,16 +568,16 @@ void Screen::text_align(sdl2::TextAlign const& align)
 	m_text_align = align;
 }
 
-std::vector<SDL_Point> Screen::line_arr(int x0, int y0, int x1, int y1)
+frame_vector<SDL_Point> Screen::line_arr(int x0, int y0, int x1, int y1)
 {
-	std::vector<SDL_Point> pts;
+	frame_vector<SDL_Point> pts(&FrameArena::get());
 
 	auto plot = [&](double x, double y, double a) 
 	{
 		pts.push_back(SDL_Point{ (int)x, (int)y });
 		
-		SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a * a);
-		SDL_RenderDrawPoint(renderer.get(), (int)x, (int)y);
+		render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a * a);
+		render_point((int)x, (int)y);
 	};
 
 	auto round = [&](double x) { return std::floor(x + 0.5); };
@@ -495,6 +659,95 @@ std::vector<SDL_Point> Screen::line_arr(int x0, int y0, int x1, int y1)
 	return pts;
 }
 
+void Screen::render_point(int x, int y)
+{
+	count(&Stats::points);
+	count(&Stats::draw_calls);
+
+	SDL_RenderDrawPoint(renderer.get(), x, y);
+}
+
+void Screen::render_rect(SDL_Rect const& rect, bool const filled)
+{
+	count(&Stats::rects);
+	count(&Stats::draw_calls);
+
+	if (filled)
+		SDL_RenderFillRect(renderer.get(), &rect);
+	else
+		SDL_RenderDrawRect(renderer.get(), &rect);
+}
+
+void Screen::render_copy(SDL_Texture* texture, SDL_Rect const& rect)
+{
+	count_texture(texture);
+	count(&Stats::copies);
+	count(&Stats::draw_calls);
+
+	SDL_RenderCopy(renderer.get(), texture, NULL, &rect);
+}
+
+// consecutive draws with the same texture don't need a rebind
+void Screen::count_texture(SDL_Texture* texture)
+{
+	if (texture != bound_texture)
+		count(&Stats::texture_binds);
+
+	bound_texture = texture;
+}
+
+// redundant colour changes are skipped, most shapes set the same colour per pixel
+void Screen::render_color(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	if (draw_clr_valid && draw_clr.r == r && draw_clr.g == g && draw_clr.b == b && draw_clr.a == a)
+		return;
+
+	count(&Stats::state_changes);
+	draw_clr = SDL_Color{ r, g, b, a };
+	draw_clr_valid = true;
+
+	SDL_SetRenderDrawColor(renderer.get(), r, g, b, a);
+}
+
+void Screen::render_texture_mod(SDL_Texture* texture, SDL_Color const& clr)
+{
+	count(&Stats::state_changes);
+
+	SDL_SetTextureColorMod(texture, clr.r, clr.g, clr.b);
+	SDL_SetTextureAlphaMod(texture, clr.a);
+}
+
+SDL_Texture* Screen::upload(SDL_Surface* surface)
+{
+	if (surface != nullptr)
+	{
+		count(&Stats::texture_uploads);
+		count(&Stats::bytes_uploaded, (int64_t)surface->pitch * surface->h);
+	}
+
+	return SDL_CreateTextureFromSurface(renderer.get(), surface);
+}
+
+void Screen::count(int64_t Stats::* field, int64_t n)
+{
+	if (!stats_paused)
+		stats.*field += n;
+}
+
+Screen::Stats& Screen::Stats::operator+=(Stats const& other)
+{
+	for (auto field : FIELDS)
+		this->*field += other.*field;
+	return *this;
+}
+
+Screen::Stats& Screen::Stats::operator-=(Stats const& other)
+{
+	for (auto field : FIELDS)
+		this->*field -= other.*field;
+	return *this;
+}
+
 SDL_Rect Screen::rect_align_coords(sdl2::RectAlign align, int x, int y, int w, int h) const
 {
 	SDL_Rect rect{ -1, -1, w, h };
@@ -527,8 +780,8 @@ SDL_Rect Screen::rect_align_coords(sdl2::RectAlign align, int x, int y, int w, i
 void Screen::line_aliase(int x0, int y0, int x1, int y1)
 {
 	auto plot = [&](int x, int y) {
-		SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a);
-		SDL_RenderDrawPoint(renderer.get(), x, y);
+		render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a);
+		render_point(x, y);
 	};
 
 	int dx = std::abs(x1 - x0);
@@ -568,8 +821,8 @@ void Screen::line_aliase(int x0, int y0, int x1, int y1)
 void Screen::line_antialiase(int x0, int y0, int x1, int y1)
 {
 	auto plot = [&](double x, double y, double a) {
-		SDL_SetRenderDrawColor(renderer.get(), stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a * a);
-		SDL_RenderDrawPoint(renderer.get(), (int)x, (int)y);
+		render_color(stroke_clr.r, stroke_clr.g, stroke_clr.b, stroke_clr.a * a);
+		render_point((int)x, (int)y);
 	};
 
 	auto round = [&](double x) { return std::floor(x + 0.5); };
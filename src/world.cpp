@@ -0,0 +1,51 @@
+#include "world.hpp"
+#include "base.hpp"
+#include "frame_arena.hpp"
+#include "jobs.hpp"
+#include "profiler.hpp"
+
+#include <cstdint>
+#include <memory>
+
+World::World()
+{
+
+}
+
+Base& World::add(uint64_t const id)
+{
+	auto& base = by_id[id];
+	if (base == nullptr)
+	{
+		bases.push_back(std::make_unique<Base>());
+		base = bases.back().get();
+		base->headless = true;
+		base->seed(id);
+	}
+
+	return *base;
+}
+
+Base* World::find(uint64_t const id)
+{
+	auto const it = by_id.find(id);
+	return it == by_id.end() ? nullptr : it->second;
+}
+
+int World::size() const
+{
+	return bases.size();
+}
+
+void World::tick(bool second)
+{
+	PROFILE_SCOPE("World::tick");
+
+	Jobs::get().parallel_for(bases.size(), BATCH, [&](int begin, int end) {
+		// pathfinding scratch goes back to the worker's arena after each batch
+		FrameArena::Scope scratch;
+
+		for (int i = begin; i < end; ++i)
+			bases[i]->tick(second);
+	});
+}
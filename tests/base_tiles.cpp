@@ -0,0 +1,84 @@
+// tile state checks for placing and moving buildings, run by ctest
+// exits non zero on the first failure
+
+#include "base.hpp"
+#include "building_type.hpp"
+#include "world.hpp"
+#include "tile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int type_of(std::string const& name)
+{
+	for (int i = 0; i < BuildingCatalog::get().size(); ++i)
+	{
+		if (BuildingCatalog::get()[i].name == name)
+			return i;
+	}
+
+	std::cout << "[error] - no building named " << name << '\n';
+	std::exit(1);
+}
+
+std::vector<uint8_t> tiles_of(Base const& base)
+{
+	return *base.snapshot().tiles;
+}
+
+bool check(bool ok, char const* what)
+{
+	if (!ok)
+		std::cout << "[error] - " << what << '\n';
+	return ok;
+}
+
+// a house built over a road and then moved off it leaves the road's tiles
+//   as path, the same as if the house had been built at its new spot
+bool move_off_road()
+{
+	int const road = type_of("road");
+	int const house = type_of("farmhouse");
+	int const road_x = 305, road_y = 300;
+	int const moved_x = 805, moved_y = 300;
+
+	World world;
+	Base& base = world.add(1);
+	if (!check(base.add_building(road, road_x, road_y), "road could not be placed"))
+		return false;
+
+	auto const road_only = tiles_of(base);
+	if (!check(base.add_building(house, road_x, road_y), "house could not be placed over the road"))
+		return false;
+
+	auto const path_count = [](std::vector<uint8_t> const& t) {
+		return std::count(t.begin(), t.end(), (uint8_t)TileState::PATH);
+	};
+	if (!check(path_count(tiles_of(base)) < path_count(road_only), "house doesn't cover the road"))
+		return false;
+
+	if (!check(base.perform(Action{ ActionType::MOVE, 1, moved_x, moved_y }), "house could not be moved"))
+		return false;
+
+	Base& expected = world.add(2);
+	expected.add_building(road, road_x, road_y);
+	expected.add_building(house, moved_x, moved_y);
+
+	return check(tiles_of(base) == tiles_of(expected), "moving the house off the road changed the road's tiles");
+}
+
+}
+
+int main()
+{
+	bool ok = true;
+	ok = move_off_road() && ok;
+
+	return ok ? 0 : 1;
+}
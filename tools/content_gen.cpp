@@ -0,0 +1,338 @@
+// reads data/content.txt and writes content_data.hpp, a constexpr table of
+//   every building, troop and upgrade with the sprite sizes already measured
+// usage: content_gen <content.txt> <assets dir> <output header>
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Section
+{
+	std::string kind;
+	std::vector<std::string> args;
+	std::map<std::string, std::vector<std::string>> keys;
+	int line;
+	std::map<std::string, int> key_lines;
+};
+
+std::string trim(std::string const& s)
+{
+	auto const b = s.find_first_not_of(" \t\r");
+	auto const e = s.find_last_not_of(" \t\r");
+	return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+std::vector<std::string> split(std::string const& s)
+{
+	std::vector<std::string> words;
+	std::istringstream ss(s);
+	for (std::string w; ss >> w;)
+		words.push_back(w);
+	return words;
+}
+
+bool parse(std::string const& path, std::vector<Section>& sections)
+{
+	std::ifstream in(path);
+	if (!in)
+	{
+		std::cout << "[error] - could not open '" << path << "'\n";
+		return false;
+	}
+
+	int line_num = 0;
+	for (std::string line; std::getline(in, line);)
+	{
+		line_num++;
+		line = trim(line.substr(0, line.find('#')));
+		if (line.empty())
+			continue;
+
+		if (line.front() == '[')
+		{
+			auto words = split(line.substr(1, line.find(']') - 1));
+			if (line.back() != ']' || words.empty())
+			{
+				std::cout << "[error] - " << path << ":" << line_num << " bad section header\n";
+				return false;
+			}
+
+			sections.push_back(Section{ words[0], { words.begin() + 1, words.end() }, {}, line_num, {} });
+			continue;
+		}
+
+		auto const eq = line.find('=');
+		if (eq == std::string::npos || sections.empty())
+		{
+			std::cout << "[error] - " << path << ":" << line_num << " expected 'key = value'\n";
+			return false;
+		}
+
+		auto const key = trim(line.substr(0, eq));
+		sections.back().keys[key] = split(line.substr(eq + 1));
+		sections.back().key_lines[key] = line_num;
+	}
+
+	return true;
+}
+
+// only the IHDR chunk is read, the image is never decoded
+bool png_size(std::string const& path, int& w, int& h)
+{
+	std::ifstream in(path, std::ios::binary);
+	unsigned char header[24];
+	if (!in.read((char*)header, sizeof(header)) || header[1] != 'P' || header[2] != 'N' || header[3] != 'G')
+	{
+		std::cout << "[error] - '" << path << "' is not a png\n";
+		return false;
+	}
+
+	auto be32 = [](unsigned char const* p) {
+		return (int)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+	};
+
+	w = be32(header + 16);
+	h = be32(header + 20);
+	return true;
+}
+
+class Writer
+{
+public:
+	Writer(Section const& _section, std::string const& _path)
+		: section(_section), path(_path), ok(true) {}
+
+	std::vector<std::string> get(std::string const& key, int count, bool required = true)
+	{
+		auto const it = section.keys.find(key);
+		if (it == section.keys.end())
+		{
+			if (required)
+				fail("missing '" + key + "'");
+			return std::vector<std::string>(count, "0");
+		}
+
+		if ((int)it->second.size() != count)
+			fail("'" + key + "' expects " + std::to_string(count) + " values", key_line(key));
+
+		auto vals = it->second;
+		vals.resize(count, "0");
+		return vals;
+	}
+
+	std::string one(std::string const& key, bool required = true)
+	{
+		return get(key, 1, required)[0];
+	}
+
+	// numbers are checked here so a typo fails with its line instead of in the generated header
+	std::string integer(std::string const& key, std::string const& val)
+	{
+		try
+		{
+			size_t end = 0;
+			int const n = std::stoi(val, &end);
+			if (end == val.size())
+				return std::to_string(n);
+		}
+		catch (std::exception const&) {}
+
+		fail("'" + key + "' expects an integer, got '" + val + "'", key_line(key));
+		return "0";
+	}
+
+	std::string real(std::string const& key, std::string const& val)
+	{
+		try
+		{
+			size_t end = 0;
+			double const n = std::stod(val, &end);
+			if (end == val.size() && std::isfinite(n))
+				return val;
+		}
+		catch (std::exception const&) {}
+
+		fail("'" + key + "' expects a number, got '" + val + "'", key_line(key));
+		return "0";
+	}
+
+	std::vector<std::string> integers(std::string const& key, int count, bool required = true)
+	{
+		auto vals = get(key, count, required);
+		for (auto& v : vals)
+			v = integer(key, v);
+		return vals;
+	}
+
+	// shop size from the png header and scale
+	std::string sprite(std::string const& assets)
+	{
+		auto const img = one("img");
+		auto const it = section.keys.find("scale");
+		auto scale = it == section.keys.end() ? std::vector<std::string>{ "1" } : it->second;
+		if (scale.size() == 1)
+			scale.push_back(scale[0]);
+		if (scale.size() != 2)
+			fail("'scale' expects 1 or 2 values", key_line("scale"));
+		for (auto& s : scale)
+			s = real("scale", s);
+
+		int w = 0, h = 0;
+		if (ok && !png_size(assets + "/" + img, w, h))
+			ok = false;
+		if (!ok)
+			return "";
+
+		return "\"" + img + "\", " + std::to_string((int)(w * std::stod(scale[0]))) + ", "
+			+ std::to_string((int)(h * std::stod(scale[1])));
+	}
+
+	std::string mapped(std::string const& val, std::map<std::string, std::string> const& names)
+	{
+		auto const it = names.find(val);
+		if (it == names.end())
+		{
+			fail("unknown value '" + val + "'");
+			return "";
+		}
+
+		return it->second;
+	}
+
+	void fail(std::string const& msg, int line = 0)
+	{
+		std::cout << "[error] - " << path << ":" << (line ? line : section.line) << " " << msg << '\n';
+		ok = false;
+	}
+
+	// line of the key, or of the section header when the key is missing
+	int key_line(std::string const& key) const
+	{
+		auto const it = section.key_lines.find(key);
+		return it == section.key_lines.end() ? section.line : it->second;
+	}
+
+public:
+	Section const& section;
+	std::string const& path;
+	bool ok;
+};
+
+std::string join(std::vector<std::string> const& vals)
+{
+	std::string s;
+	for (auto const& v : vals)
+		s += (s.empty() ? "" : ", ") + v;
+	return s;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 4)
+	{
+		std::cout << "usage: content_gen <content.txt> <assets dir> <output header>\n";
+		return 1;
+	}
+
+	std::string const path = argv[1];
+	std::string const assets = argv[2];
+
+	std::vector<Section> sections;
+	if (!parse(path, sections))
+		return 1;
+
+	std::map<std::string, std::string> const tiles{
+		{ "grass", "TileState::GRASS" }, { "path", "TileState::PATH" }, { "occupied", "TileState::OCCUPIED" } };
+	std::map<std::string, std::string> const prods{
+		{ "gold", "ProdType::GOLD" }, { "wheat", "ProdType::WHEAT" }, { "wood", "ProdType::WOOD" },
+		{ "stone", "ProdType::STONE" }, { "iron", "ProdType::IRON" } };
+
+	std::vector<std::string> buildings, troops, upgrades;
+	bool ok = true;
+	for (auto const& section : sections)
+	{
+		Writer w(section, path);
+		std::string row;
+
+		if (section.kind == "building" && section.args.size() == 1)
+		{
+			row = "\"" + section.args[0] + "\", " + w.sprite(assets) + ", "
+				+ w.real("base_scale", w.one("base_scale")) + ", " + w.integer("height", w.one("height")) + ", "
+				+ join(w.integers("cost", 4)) + ", "
+				+ w.mapped(w.one("tile"), tiles) + ", ";
+
+			if (section.keys.count("prod"))
+			{
+				auto prod = w.get("prod", 4);
+				row += "true, " + w.mapped(prod[0], prods) + ", " + w.integer("prod", prod[1]) + ", "
+					+ w.integer("prod", prod[2]) + ", " + w.integer("prod", prod[3]);
+			}
+			else
+				row += "false, ProdType::GOLD, 0, 0, 0";
+
+			buildings.push_back(row);
+		}
+		else if (section.kind == "troop" && section.args.size() == 1)
+		{
+			row = "\"" + section.args[0] + "\", " + w.sprite(assets) + ", " + join(w.integers("cost", 2)) + ", "
+				+ w.integer("hp", w.one("hp")) + ", " + w.integer("damage", w.one("damage")) + ", "
+				+ w.real("speed", w.one("speed")) + ", " + w.integer("train_time", w.one("train_time"));
+
+			troops.push_back(row);
+		}
+		else if (section.kind == "upgrade" && section.args.size() == 2)
+		{
+			row = "\"" + section.args[0] + "\", " + w.integer("level", section.args[1]) + ", "
+				+ join(w.integers("cost", 4)) + ", " + join(w.integers("prod", 3, false));
+
+			upgrades.push_back(row);
+		}
+		else
+			w.fail("unknown section '" + section.kind + "'");
+
+		ok = ok && w.ok;
+	}
+
+	if (!ok)
+		return 1;
+
+	std::ostringstream out;
+	out << "#pragma once\n\n"
+		<< "// generated from data/content.txt by content_gen, do not edit\n\n"
+		<< "#include \"content.hpp\"\n\n"
+		<< "#include <array>\n\n"
+		<< "namespace content\n{\n\n";
+
+	auto table = [&](char const* type, char const* name, std::vector<std::string> const& rows) {
+		out << "inline constexpr std::array<" << type << ", " << rows.size() << "> " << name << "{{\n";
+		for (auto const& row : rows)
+			out << "\t{ " << row << " },\n";
+		out << "}};\n\n";
+	};
+
+	table("BuildingDef", "buildings", buildings);
+	table("TroopDef", "troops", troops);
+	table("UpgradeDef", "upgrades", upgrades);
+
+	out << "}\n";
+
+	std::ofstream file(argv[3], std::ios::binary);
+	file << out.str();
+	if (!file)
+	{
+		std::cout << "[error] - could not write '" << argv[3] << "'\n";
+		return 1;
+	}
+
+	return 0;
+}